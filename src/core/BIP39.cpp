@@ -14,6 +14,52 @@ bip3x::HDKey BIP39::createKey(std::string phrase, std::string derivPath) {
   return rootKey;
 }
 
+bip3x::HDKey BIP39::createParentKey(std::string phrase, std::string derivPath) {
+  return BIP39::createKey(phrase, derivPath);
+}
+
+int64_t BIP39::deriveAccounts(
+  const bip3x::HDKey &parent, int64_t start, int64_t count, DeriveFunc func
+) {
+  // Each round derives one chunk per thread, then hands the results to func
+  // in order before starting the next round, so at most
+  // (threads * chunkSize) keys are held in memory at once.
+  const int64_t chunkSize = 64;
+  int64_t threads = std::max(1u, std::thread::hardware_concurrency());
+  int64_t done = 0;
+  std::vector<std::vector<KeyPair>> chunks(threads);
+  while (done < count) {
+    int64_t roundStart = start + done;
+    int64_t roundSize = std::min(count - done, threads * chunkSize);
+    int64_t roundThreads = (roundSize + chunkSize - 1) / chunkSize;
+    std::vector<std::thread> workers;
+    for (int64_t t = 0; t < roundThreads; t++) {
+      workers.emplace_back([&, t]{
+        std::vector<KeyPair> &chunk = chunks[t];
+        chunk.clear();
+        int64_t first = roundStart + (t * chunkSize);
+        int64_t last = std::min(first + chunkSize, roundStart + roundSize);
+        for (int64_t i = first; i < last; i++) {
+          // Only the last (non-hardened) level is derived from the parent
+          bip3x::HDKey key = parent;
+          bip3x::HDKeyEncoder::makeExtendedKey(key, "m/" + boost::lexical_cast<std::string>(i));
+          chunk.emplace_back(Secret::frombip3x(key.privateKey));
+          key.clear();
+        }
+      });
+    }
+    for (std::thread &w : workers) { w.join(); }
+    for (int64_t t = 0; t < roundThreads; t++) {
+      for (const KeyPair &k : chunks[t]) {
+        if (!func(start + done, k)) { return done + 1; }
+        done++;
+      }
+      chunks[t].clear();
+    }
+  }
+  return done;
+}
+
 bool BIP39::wordExists(std::string word) {
   struct words* wordlist;
   bip39_get_wordlist(NULL, &wordlist);
@@ -21,16 +67,16 @@ bool BIP39::wordExists(std::string word) {
   return (idx != 0);
 }
 
-std::vector<std::string> BIP39::generateAccountsFromSeed(std::string seed, int64_t index) {
+std::vector<std::string> BIP39::generateAccountsFromSeed(
+  std::string seed, int64_t start, int64_t count
+) {
   std::vector<std::string> ret;
-  for (int64_t i = 0; i < 10; ++i, ++index) {
-    std::string address;
-    std::string derivPath = "m/44'/60'/0'/0/" + boost::lexical_cast<std::string>(index);
-    bip3x::HDKey rootKey = BIP39::createKey(seed, derivPath);
-    KeyPair k(Secret::frombip3x(rootKey.privateKey));
-    address += boost::lexical_cast<std::string>(index) + " " + "0x" + k.address().hex();
-    ret.push_back(address);
-  }
+  bip3x::HDKey parentKey = BIP39::createParentKey(seed);
+  BIP39::deriveAccounts(parentKey, start, count, [&](int64_t index, const KeyPair &k){
+    ret.push_back(boost::lexical_cast<std::string>(index) + " " + "0x" + k.address().hex());
+    return true;
+  });
+  parentKey.clear();
   return ret;
 }
 
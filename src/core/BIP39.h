@@ -4,7 +4,10 @@
 #ifndef BIP39_H
 #define BIP39_H
 
+#include <algorithm>
+#include <functional>
 #include <string>
+#include <thread>
 #include <vector>
 #include <utility>
 
@@ -40,6 +43,31 @@ namespace BIP39 {
    */
   bip3x::HDKey createKey(std::string phrase, std::string derivPath);
 
+  /**
+   * Create the parent key for a range of Accounts using a mnemonic phrase
+   * and the parent's derivation path (e.g. "m/44'/60'/0'/0").
+   * Generating the seed and the hardened derivations are by far the slowest
+   * part of deriving an Account, so this should be done only once per range.
+   * Returns the parent key.
+   */
+  bip3x::HDKey createParentKey(std::string phrase, std::string derivPath = "m/44'/60'/0'/0");
+
+  /**
+   * Callback for deriveAccounts(). Receives each index and its key pair,
+   * in index order. Returns false to stop the derivation early.
+   */
+  typedef std::function<bool(int64_t, const KeyPair&)> DeriveFunc;
+
+  /**
+   * Derive the Accounts in the range [start, start + count) from a parent key,
+   * in parallel across all cores. Results are streamed to func in chunks,
+   * so memory use stays the same no matter how big the range is.
+   * Returns how many Accounts were passed to func.
+   */
+  int64_t deriveAccounts(
+    const bip3x::HDKey &parent, int64_t start, int64_t count, DeriveFunc func
+  );
+
   /**
    * Check if a word exists in the English BIP39 wordlist.
    * Returns true on success, false on failure.
@@ -47,10 +75,12 @@ namespace BIP39 {
   bool wordExists(std::string word);
 
   /**
-   * Generate a list with 10 Accounts based on a given seed and a starting index.
-   * Returns a vector with the addresses.
+   * Generate a list of Accounts (10 by default) based on a given seed and a starting index.
+   * Returns a vector with the indexes and addresses (e.g. "0 0x123...").
    */
-  std::vector<std::string> generateAccountsFromSeed(std::string seed, int64_t start);
+  std::vector<std::string> generateAccountsFromSeed(
+    std::string seed, int64_t start, int64_t count = 10
+  );
 
   /**
    * Save a mnemonic phrase to a JSON file in the default path.
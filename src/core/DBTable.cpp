@@ -0,0 +1,183 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "DBTable.h"
+
+void DBBatch::putValue(const DBTable &table, std::string key, std::string value) {
+  this->batch.Put(table.prefix + key, value);
+  this->ops++;
+}
+
+void DBBatch::deleteValue(const DBTable &table, std::string key) {
+  this->batch.Delete(table.prefix + key);
+  this->ops++;
+}
+
+DBTable DBTable::subTable(std::string name) const {
+  return DBTable(this->db, this->prefix + std::string(1, '\0') + name + "/");
+}
+
+void DBTable::bounds(
+  std::string from, std::string to, bool withSubTables,
+  std::string &lower, std::string &upper
+) const {
+  // Sub-table keys start with '\0', so they sort first in the root table.
+  // Keys inside a sub-table can be anything (including a leading '\0').
+  lower = (withSubTables || !this->prefix.empty()) ? this->prefix : "\x01";
+  if (!from.empty() && this->prefix + from > lower) { lower = this->prefix + from; }
+
+  // Everything with the prefix sorts before the prefix with its last byte
+  // incremented (prefixes always end in '/', so there's no overflow)
+  upper = this->prefix;
+  if (!upper.empty()) { upper.back()++; }
+  if (!to.empty()) { upper = this->prefix + to; }
+}
+
+size_t DBTable::scanRaw(
+  std::string lower, std::string upper, DBScanFunc func,
+  bool reverse, const DBSnapshot &snapshot
+) const {
+  size_t ret = 0;
+  if (!this->isOpen()) { return ret; }
+  leveldb::ReadOptions opts;
+  opts.snapshot = snapshot.get();
+  opts.fill_cache = false;  // Scans shouldn't push hot keys out of the cache
+  leveldb::Iterator* it = this->db->NewIterator(opts);
+  leveldb::Slice lowerSlice(lower), upperSlice(upper);
+  if (!reverse) {
+    for (it->Seek(lowerSlice); it->Valid(); it->Next()) {
+      if (!upper.empty() && it->key().compare(upperSlice) >= 0) { break; }
+      ret++;
+      if (!func(it->key().ToString().substr(this->prefix.size()), it->value().ToString())) { break; }
+    }
+  } else {
+    if (upper.empty()) {
+      it->SeekToLast();
+    } else {
+      it->Seek(upperSlice);
+      if (it->Valid()) { it->Prev(); } else { it->SeekToLast(); }
+    }
+    for (; it->Valid(); it->Prev()) {
+      if (it->key().compare(lowerSlice) < 0) { break; }
+      ret++;
+      if (!func(it->key().ToString().substr(this->prefix.size()), it->value().ToString())) { break; }
+    }
+  }
+  delete it;
+  return ret;
+}
+
+bool DBTable::keyExists(std::string key, const DBSnapshot &snapshot) const {
+  std::string value;
+  return this->getValue(key, value, snapshot);
+}
+
+bool DBTable::getValue(std::string key, std::string &value, const DBSnapshot &snapshot) const {
+  if (!this->isOpen()) { return false; }
+  leveldb::ReadOptions opts;
+  opts.snapshot = snapshot.get();
+  return this->db->Get(opts, this->prefix + key, &value).ok();
+}
+
+std::string DBTable::getValue(std::string key) const {
+  if (!this->isOpen()) { return "NotFound: "; }
+  std::string value;
+  leveldb::Status status = this->db->Get(leveldb::ReadOptions(), this->prefix + key, &value);
+  return (status.ok()) ? value : status.ToString();
+}
+
+bool DBTable::putValue(std::string key, std::string value) {
+  if (!this->isOpen()) { return false; }
+  return this->db->Put(leveldb::WriteOptions(), this->prefix + key, value).ok();
+}
+
+bool DBTable::deleteValue(std::string key) {
+  if (!this->isOpen()) { return false; }
+  return this->db->Delete(leveldb::WriteOptions(), this->prefix + key).ok();
+}
+
+bool DBTable::write(DBBatch &batch, bool sync) {
+  if (!this->isOpen()) { return false; }
+  if (batch.size() == 0) { return true; }
+  leveldb::WriteOptions opts;
+  opts.sync = sync;
+  return this->db->Write(opts, &batch.batch).ok();
+}
+
+bool DBTable::putValues(const std::vector<std::pair<std::string, std::string>> &values) {
+  DBBatch batch;
+  for (const std::pair<std::string, std::string> &value : values) {
+    batch.putValue(*this, value.first, value.second);
+  }
+  return this->write(batch);
+}
+
+bool DBTable::deleteValues(const std::vector<std::string> &keys) {
+  DBBatch batch;
+  for (const std::string &key : keys) { batch.deleteValue(*this, key); }
+  return this->write(batch);
+}
+
+size_t DBTable::scan(
+  DBScanFunc func, std::string from, std::string to,
+  bool reverse, const DBSnapshot &snapshot
+) const {
+  std::string lower, upper;
+  this->bounds(from, to, false, lower, upper);
+  return this->scanRaw(lower, upper, func, reverse, snapshot);
+}
+
+bool DBTable::isEmpty(const DBSnapshot &snapshot) const {
+  if (!this->isOpen()) { return true; }
+  std::string lower, upper;
+  this->bounds("", "", false, lower, upper);
+  leveldb::ReadOptions opts;
+  opts.snapshot = snapshot.get();
+  opts.fill_cache = false;
+  leveldb::Iterator* it = this->db->NewIterator(opts);
+  // Only the first key in the table's range matters (sub-table keys sort before it)
+  it->Seek(lower);
+  bool ret = (!it->Valid() || (!upper.empty() && it->key().compare(leveldb::Slice(upper)) >= 0));
+  delete it;
+  return ret;
+}
+
+std::vector<std::string> DBTable::getAllKeys(const DBSnapshot &snapshot) const {
+  std::vector<std::string> ret;
+  this->scan([&](const std::string &key, const std::string &value){
+    ret.push_back(key);
+    return true;
+  }, "", "", false, snapshot);
+  return ret;
+}
+
+std::vector<std::string> DBTable::getAllValues(const DBSnapshot &snapshot) const {
+  std::vector<std::string> ret;
+  this->scan([&](const std::string &key, const std::string &value){
+    ret.push_back(value);
+    return true;
+  }, "", "", false, snapshot);
+  return ret;
+}
+
+bool DBTable::deleteAll(bool withSubTables) {
+  if (!this->isOpen()) { return false; }
+  // Keys are collected from a snapshot, so the iterator doesn't see the deletes
+  std::string lower, upper;
+  this->bounds("", "", withSubTables, lower, upper);
+  DBBatch batch;
+  DBTable root(this->db);
+  this->scanRaw(lower, upper, [&](const std::string &key, const std::string &value){
+    batch.deleteValue(root, this->prefix + key);
+    return true;
+  }, false, this->getSnapshot());
+  return this->write(batch);
+}
+
+DBSnapshot DBTable::getSnapshot() const {
+  if (!this->isOpen()) { return nullptr; }
+  leveldb::DB* db = this->db;
+  return DBSnapshot(db->GetSnapshot(), [db](const leveldb::Snapshot* snapshot){
+    db->ReleaseSnapshot(snapshot);
+  });
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef DBTABLE_H
+#define DBTABLE_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <leveldb/db.h>
+#include <leveldb/write_batch.h>
+
+class DBTable;
+
+// Callback for range scans. Receives each key (without the table's prefix)
+// and its value. Returns false to stop the scan early.
+typedef std::function<bool(const std::string&, const std::string&)> DBScanFunc;
+
+// A consistent, read-only view of a database at a given point in time.
+// Released automatically when the last copy goes away.
+typedef std::shared_ptr<const leveldb::Snapshot> DBSnapshot;
+
+/**
+ * A group of puts and deletes that are applied atomically, in one write.
+ * Can hold operations for any tables in the same database
+ * (e.g. a table and its sub-tables).
+ */
+class DBBatch {
+  private:
+    leveldb::WriteBatch batch;
+    size_t ops = 0;
+    friend class DBTable;
+
+  public:
+    void putValue(const DBTable &table, std::string key, std::string value);
+    void deleteValue(const DBTable &table, std::string key);
+    size_t size() { return this->ops; }
+    void clear() { this->batch.Clear(); this->ops = 0; }
+};
+
+/**
+ * View of a key range inside a LevelDB database.
+ * The root table of a database has no prefix. Sub-tables live in the same
+ * database under a reserved prefix ('\0' + name + '/'), work like separate
+ * column families and are skipped when scanning the root table.
+ * Sub-tables should only be created from the root table, so their own keys
+ * can be any bytes (e.g. big-endian numbers).
+ * Tables don't own the database and are cheap to copy, but must not be
+ * used after the database is closed.
+ * All functions fail gracefully (false/empty) if the database isn't open.
+ */
+class DBTable {
+  private:
+    leveldb::DB* db;
+    std::string prefix;
+    friend class DBBatch;
+
+    // Get the raw key range for a scan. An empty upper bound means "until the end".
+    void bounds(
+      std::string from, std::string to, bool withSubTables,
+      std::string &lower, std::string &upper
+    ) const;
+
+    // Scan a raw key range, calling func with the unprefixed key and the value.
+    size_t scanRaw(
+      std::string lower, std::string upper, DBScanFunc func,
+      bool reverse, const DBSnapshot &snapshot
+    ) const;
+
+  public:
+    DBTable(leveldb::DB* db = NULL, std::string prefix = "") : db(db), prefix(prefix) {}
+
+    /**
+     * Get a sub-table with the given name, stored in the same database.
+     * Writes to a table and its sub-tables can share one DBBatch.
+     */
+    DBTable subTable(std::string name) const;
+
+    bool isOpen() const { return (this->db != NULL); }
+
+    // Single key operations. Reads can optionally be done from a snapshot.
+    bool keyExists(std::string key, const DBSnapshot &snapshot = nullptr) const;
+    bool getValue(std::string key, std::string &value, const DBSnapshot &snapshot = nullptr) const;
+    bool putValue(std::string key, std::string value);
+    bool deleteValue(std::string key);
+
+    /**
+     * Get a value, or the error status as a string (e.g. "NotFound: ")
+     * if the key doesn't exist.
+     */
+    std::string getValue(std::string key) const;
+
+    // Apply a batch atomically. Returns false and leaves the database untouched on failure.
+    bool write(DBBatch &batch, bool sync = false);
+
+    // Put or delete several keys in one atomic write.
+    bool putValues(const std::vector<std::pair<std::string, std::string>> &values);
+    bool deleteValues(const std::vector<std::string> &keys);
+
+    /**
+     * Scan the table's keys in the range [from, to), in order (or in
+     * reverse order). Empty bounds mean the start/end of the table.
+     * Returns how many keys were visited.
+     */
+    size_t scan(
+      DBScanFunc func, std::string from = "", std::string to = "",
+      bool reverse = false, const DBSnapshot &snapshot = nullptr
+    ) const;
+
+    // Check if the table has no keys, without reading through it.
+    bool isEmpty(const DBSnapshot &snapshot = nullptr) const;
+
+    // Get all keys or values in the table, in key order.
+    std::vector<std::string> getAllKeys(const DBSnapshot &snapshot = nullptr) const;
+    std::vector<std::string> getAllValues(const DBSnapshot &snapshot = nullptr) const;
+
+    /**
+     * Delete every key in the table in one atomic write.
+     * Sub-tables are only cleared along with the root table if asked to.
+     */
+    bool deleteAll(bool withSubTables = false);
+
+    // Take a snapshot of the whole database for consistent reads.
+    DBSnapshot getSnapshot() const;
+};
+
+#endif  // DBTABLE_H
@@ -7,138 +7,116 @@
 #include <string>
 
 #include <network/Pangolin.h>
+#include <core/DBTable.h>
 #include <core/Utils.h>
 
 #include <lib/nlohmann_json/json.hpp>
 #include <boost/filesystem.hpp>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
 
 using namespace boost::filesystem;
 
 /**
  * Class for abstracting LevelDB operations.
+ * Each database is opened at its own path and accessed through a DBTable,
+ * which also provides its sub-tables, batched writes, scans and snapshots.
  */
 class Database {
   private:
-    // The ARC20 token database, options, status and value.
-    leveldb::DB* tokenDB;
-    leveldb::Options tokenOpts;
-    leveldb::Status tokenStatus;
-    std::string tokenValue;
-
-    // The tx history database, options, status and value.
-    leveldb::DB* historyDB;
-    leveldb::Options historyOpts;
-    leveldb::Status historyStatus;
-    std::string historyValue;
-
-    // The Ledger account database, options, status and value.
-    leveldb::DB* ledgerDB;
-    leveldb::Options ledgerOpts;
-    leveldb::Status ledgerStatus;
-    std::string ledgerValue;
-
-    // The local DApp database, options, status and value.
-    leveldb::DB* appDB;
-    leveldb::Options appOpts;
-    leveldb::Status appStatus;
-    std::string appValue;
-
-    // The contacts database, options, status and value.
-    leveldb::DB* addressDB;
-    leveldb::Options addressOpts;
-    leveldb::Status addressStatus;
-    std::string addressValue;
-
-    // The settings database, options, status and value.
-    leveldb::DB* configDB;
-    leveldb::Options configOpts;
-    leveldb::Status configStatus;
-    std::string configValue;
+    // A LevelDB instance, its options and the status of the last open.
+    typedef struct Instance {
+      leveldb::DB* db = NULL;
+      leveldb::Options opts;
+      leveldb::Status status;
+    } Instance;
+
+    // The ARC20 token, tx history, Ledger account, local DApp, contacts and settings databases.
+    Instance tokenDB;
+    Instance historyDB;
+    Instance ledgerDB;
+    Instance appDB;
+    Instance addressDB;
+    Instance configDB;
+
+    /**
+     * Bloom filter shared by all databases (LevelDB keeps one per table file),
+     * so looking up a key that doesn't exist usually skips reading the disk.
+     */
+    const leveldb::FilterPolicy* bloomFilter = NULL;
+
+    // Open a database at the given path, creating it if needed.
+    bool openDB(Instance &inst, std::string path);
+
+    // Close a database. Does nothing if it's not open.
+    void closeDB(Instance &inst);
 
   public:
-    // Constructor. Set up any required options here.
-    Database() {
-      this->tokenOpts.create_if_missing = true;
-      this->historyOpts.create_if_missing = true;
-      this->ledgerOpts.create_if_missing = true;
-      this->appOpts.create_if_missing = true;
-      this->addressOpts.create_if_missing = true;
-      this->configOpts.create_if_missing = true;
-      tokenDB = historyDB = ledgerDB = appDB = addressDB = configDB = NULL;
+    /**
+     * Constructor. Set up any required options here.
+     * The bloom filter is optional, but it can't be changed after opening a
+     * database (LevelDB only uses it for tables written with it set).
+     */
+    Database(bool useBloomFilter = true) {
+      if (useBloomFilter) { this->bloomFilter = leveldb::NewBloomFilterPolicy(10); }
+      for (Instance* inst : {&tokenDB, &historyDB, &ledgerDB, &appDB, &addressDB, &configDB}) {
+        inst->opts.create_if_missing = true;
+        inst->opts.filter_policy = this->bloomFilter;
+      }
     }
 
-    // Token database functions.
+    // Destructor. Databases must be closed before the filter is freed.
+    ~Database() {
+      closeTokenDB(); closeHistoryDB(); closeLedgerDB();
+      closeAppDB(); closeAddressDB(); closeConfigDB();
+      delete this->bloomFilter;
+    }
+
+    // Not copyable, as it owns the database handles.
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    // Token database functions. AVME is added when the database is created.
     bool openTokenDB();
-    std::string getTokenDBStatus();
-    void closeTokenDB();
-    bool isTokenDBOpen();
-    bool tokenDBKeyExists(std::string key);
-    std::string getTokenDBValue(std::string key);
-    bool putTokenDBValue(std::string key, std::string value);
-    bool deleteTokenDBValue(std::string key);
-    std::vector<std::string> getAllTokenDBValues();
-    void deleteAllTokenDBKeys();
-
-    // Tx history database functions.
+    std::string getTokenDBStatus() { return this->tokenDB.status.ToString(); }
+    void closeTokenDB() { closeDB(this->tokenDB); }
+    bool isTokenDBOpen() { return (this->tokenDB.db != NULL); }
+    DBTable tokenTable() { return DBTable(this->tokenDB.db); }
+
+    // Tx history database functions. Each Account has its own database.
     bool openHistoryDB(std::string address);
-    std::string getHistoryDBStatus();
-    void closeHistoryDB();
-    bool isHistoryDBOpen();
-    bool historyDBKeyExists(std::string key);
-    std::string getHistoryDBValue(std::string key);
-    bool putHistoryDBValue(std::string key, std::string value);
-    bool deleteHistoryDBValue(std::string key);
-    std::vector<std::string> getAllHistoryDBValues();
-    void deleteAllHistoryDBKeys();
+    std::string getHistoryDBStatus() { return this->historyDB.status.ToString(); }
+    void closeHistoryDB() { closeDB(this->historyDB); }
+    bool isHistoryDBOpen() { return (this->historyDB.db != NULL); }
+    DBTable historyTable() { return DBTable(this->historyDB.db); }
 
     // Ledger account database functions.
     bool openLedgerDB();
-    std::string getLedgerDBStatus();
-    void closeLedgerDB();
-    bool isLedgerDBOpen();
-    bool ledgerDBKeyExists(std::string key);
-    std::string getLedgerDBValue(std::string key);
-    bool putLedgerDBValue(std::string key, std::string value);
-    bool deleteLedgerDBValue(std::string key);
-    std::vector<std::string> getAllLedgerDBValues();
-    void deleteAllLedgerDBKeys();
+    std::string getLedgerDBStatus() { return this->ledgerDB.status.ToString(); }
+    void closeLedgerDB() { closeDB(this->ledgerDB); }
+    bool isLedgerDBOpen() { return (this->ledgerDB.db != NULL); }
+    DBTable ledgerTable() { return DBTable(this->ledgerDB.db); }
 
     // DApp database functions.
     bool openAppDB();
-    std::string getAppDBStatus();
-    void closeAppDB();
-    bool isAppDBOpen();
-    bool appDBKeyExists(std::string key);
-    std::string getAppDBValue(std::string key);
-    bool putAppDBValue(std::string key, std::string value);
-    bool deleteAppDBValue(std::string key);
-    std::vector<std::string> getAllAppDBValues();
-    void deleteAllAppDBKeys();
+    std::string getAppDBStatus() { return this->appDB.status.ToString(); }
+    void closeAppDB() { closeDB(this->appDB); }
+    bool isAppDBOpen() { return (this->appDB.db != NULL); }
+    DBTable appTable() { return DBTable(this->appDB.db); }
 
     // Contacts database functions.
     bool openAddressDB();
-    std::string getAddressDBStatus();
-    void closeAddressDB();
-    bool isAddressDBOpen();
-    bool addressDBKeyExists(std::string key);
-    std::string getAddressDBValue(std::string key);
-    bool putAddressDBValue(std::string key, std::string value);
-    bool deleteAddressDBValue(std::string key);
-    std::vector<std::string> getAllAddressDBValues();
-    void deleteAllAddressDBKeys();
+    std::string getAddressDBStatus() { return this->addressDB.status.ToString(); }
+    void closeAddressDB() { closeDB(this->addressDB); }
+    bool isAddressDBOpen() { return (this->addressDB.db != NULL); }
+    DBTable addressTable() { return DBTable(this->addressDB.db); }
 
     // Settings database functions.
     bool openConfigDB();
-    std::string getConfigDBStatus();
-    void closeConfigDB();
-    bool isConfigDBOpen();
-    bool configDBKeyExists(std::string key);
-    std::string getConfigDBValue(std::string key);
-    bool putConfigDBValue(std::string key, std::string value);
-    bool deleteConfigDBValue(std::string key);
-    std::vector<std::string> getAllConfigDBValues();
-    void deleteAllConfigDBKeys();
+    std::string getConfigDBStatus() { return this->configDB.status.ToString(); }
+    void closeConfigDB() { closeDB(this->configDB); }
+    bool isConfigDBOpen() { return (this->configDB.db != NULL); }
+    DBTable configTable() { return DBTable(this->configDB.db); }
 };
 
 #endif  // DATABASE_H
@@ -0,0 +1,137 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "KeySession.h"
+
+KeySession::KeySession() : pool(maxSlots * Secret::size), usedSlots(maxSlots, false), salt(h256::random()) {
+  // Locking can fail without privileges/quota (e.g. RLIMIT_MEMLOCK),
+  // in which case secrets are still wiped, just not pinned to RAM
+  bytesRef poolRef = this->pool.ref();
+  #ifdef __MINGW32__
+    this->poolLocked = VirtualLock(poolRef.data(), poolRef.size());
+  #else
+    this->poolLocked = (mlock(poolRef.data(), poolRef.size()) == 0);
+  #endif
+  if (!this->poolLocked) {
+    Utils::logToDebug("KeySession: could not lock secrets in memory");
+  }
+  this->reaper = std::thread(&KeySession::reaperLoop, this);
+}
+
+KeySession::~KeySession() {
+  this->entriesLock.lock();
+  this->stopped = true;
+  this->entriesLock.unlock();
+  this->reaperCond.notify_all();
+  this->reaper.join();
+  this->lockAll();
+  bytesRef poolRef = this->pool.ref();
+  poolRef.cleanse();
+  if (this->poolLocked) {
+    #ifdef __MINGW32__
+      VirtualUnlock(poolRef.data(), poolRef.size());
+    #else
+      munlock(poolRef.data(), poolRef.size());
+    #endif
+  }
+}
+
+void KeySession::wipe(std::map<Address, KeySessionEntry>::iterator it) {
+  this->pool.ref().cropped(it->second.slot * Secret::size, Secret::size).cleanse();
+  this->usedSlots[it->second.slot] = false;
+  this->entries.erase(it);
+}
+
+h256 KeySession::hashPass(const std::string &pass) {
+  return dev::sha3(this->salt.hex() + pass);
+}
+
+void KeySession::reaperLoop() {
+  std::unique_lock<std::mutex> lock(this->entriesLock);
+  while (!this->stopped) {
+    this->reaperCond.wait_for(lock, std::chrono::seconds(1));
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (auto it = this->entries.begin(); it != this->entries.end();) {
+      auto next = std::next(it);
+      if (now >= it->second.deadline) { this->wipe(it); }
+      it = next;
+    }
+  }
+}
+
+bool KeySession::unlock(
+  Address address, const Secret &secret, const std::string &pass,
+  unsigned seconds, unsigned maxUses
+) {
+  h256 passCheck = this->hashPass(pass);
+  this->entriesLock.lock();
+  auto it = this->entries.find(address);
+  size_t slot = maxSlots;
+  if (it != this->entries.end()) {
+    slot = it->second.slot;
+  } else {
+    for (size_t i = 0; i < maxSlots; i++) {
+      if (!this->usedSlots[i]) { slot = i; break; }
+    }
+  }
+  if (slot == maxSlots) {
+    this->entriesLock.unlock();
+    return false;
+  }
+  secret.ref().copyTo(this->pool.ref().cropped(slot * Secret::size, Secret::size));
+  this->usedSlots[slot] = true;
+  KeySessionEntry entry;
+  entry.slot = slot;
+  entry.deadline = (seconds > 0)
+    ? std::chrono::steady_clock::now() + std::chrono::seconds(seconds)
+    : std::chrono::steady_clock::time_point::max();
+  entry.usesLeft = maxUses;
+  entry.passCheck = passCheck;
+  this->entries[address] = entry;
+  this->entriesLock.unlock();
+  return true;
+}
+
+bool KeySession::isUnlocked(Address address) {
+  this->entriesLock.lock();
+  auto it = this->entries.find(address);
+  bool ret = (it != this->entries.end() && std::chrono::steady_clock::now() < it->second.deadline);
+  this->entriesLock.unlock();
+  return ret;
+}
+
+bool KeySession::useSecret(Address address, const std::string &pass, Secret &secret) {
+  h256 passCheck = this->hashPass(pass);
+  this->entriesLock.lock();
+  auto it = this->entries.find(address);
+  if (it == this->entries.end() || it->second.passCheck != passCheck) {
+    this->entriesLock.unlock();
+    return false;
+  }
+  if (std::chrono::steady_clock::now() >= it->second.deadline) {
+    this->wipe(it);
+    this->entriesLock.unlock();
+    return false;
+  }
+  secret = Secret(
+    this->pool.ref().cropped(it->second.slot * Secret::size, Secret::size).data(),
+    h256::ConstructFromPointer
+  );
+  // Wipe the secret right after its last allowed signature
+  if (it->second.usesLeft > 0 && --it->second.usesLeft == 0) { this->wipe(it); }
+  this->entriesLock.unlock();
+  return true;
+}
+
+void KeySession::lock(Address address) {
+  this->entriesLock.lock();
+  auto it = this->entries.find(address);
+  if (it != this->entries.end()) { this->wipe(it); }
+  this->entriesLock.unlock();
+}
+
+void KeySession::lockAll() {
+  this->entriesLock.lock();
+  while (!this->entries.empty()) { this->wipe(this->entries.begin()); }
+  this->entriesLock.unlock();
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef KEYSESSION_H
+#define KEYSESSION_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <core/Utils.h>
+#include <lib/devcore/SHA3.h>
+
+#ifndef __MINGW32__
+#include <sys/mman.h>
+#endif
+
+using namespace dev;  // Secret, Address
+
+// An unlocked Account: where its secret lives in the pool, when the
+// session ends, how many signatures are left (0 = no limit) and the
+// salted hash of the password it was unlocked with.
+typedef struct KeySessionEntry {
+  size_t slot;
+  std::chrono::steady_clock::time_point deadline;
+  unsigned usesLeft;
+  h256 passCheck;
+} KeySessionEntry;
+
+/**
+ * Cache of decrypted Account secrets, so repeated signatures don't have to
+ * run the keyfile's KDF (scrypt/pbkdf2) again every time.
+ * Each Account is unlocked for a given time and/or number of signatures.
+ * Secrets are kept in a fixed pool that is locked in RAM (never swapped
+ * to disk) and zeroed when an Account is locked again or expires.
+ * A reaper thread wipes expired secrets every second.
+ * Using a secret still takes the Account's password, which is checked
+ * against a salted hash kept when unlocking (cheap, unlike the KDF),
+ * so an unlocked session never signs with a wrong password.
+ */
+class KeySession {
+  private:
+    // Max number of Accounts that can be unlocked at the same time.
+    static const size_t maxSlots = 64;
+
+    // The pool of secrets, and which slots are in use.
+    bytesSec pool;
+    std::vector<bool> usedSlots;
+    bool poolLocked = false;
+
+    // Unlocked Accounts and their slots.
+    std::map<Address, KeySessionEntry> entries;
+    std::mutex entriesLock;
+
+    // Random salt for the password checks, new for every session.
+    h256 salt;
+
+    // Salted hash of a password, to compare with an entry's passCheck.
+    h256 hashPass(const std::string &pass);
+
+    // The reaper thread and its stop signal.
+    std::thread reaper;
+    std::condition_variable reaperCond;
+    bool stopped = false;
+
+    // Wipe an Account's secret and free its slot. Caller must hold entriesLock.
+    void wipe(std::map<Address, KeySessionEntry>::iterator it);
+
+    // Wipe expired Accounts until the session is destroyed.
+    void reaperLoop();
+
+  public:
+    KeySession();
+    ~KeySession();
+    KeySession(const KeySession&) = delete;
+    KeySession& operator=(const KeySession&) = delete;
+
+    /**
+     * Unlock an Account with its already decrypted secret and the password
+     * it was decrypted with, for the given number of seconds and signatures
+     * (0 = no limit for either, but at least one should be set).
+     * Unlocking again renews the session.
+     * Returns false if the pool is full.
+     */
+    bool unlock(
+      Address address, const Secret &secret, const std::string &pass,
+      unsigned seconds, unsigned maxUses
+    );
+
+    // Check if an Account is unlocked (and not expired).
+    bool isUnlocked(Address address);
+
+    /**
+     * Get the secret for an unlocked Account, counting it as one signature.
+     * Returns false if the Account isn't unlocked or the password is wrong.
+     */
+    bool useSecret(Address address, const std::string &pass, Secret &secret);
+
+    // Lock an Account, or all of them, wiping their secrets.
+    void lock(Address address);
+    void lockAll();
+};
+
+#endif  // KEYSESSION_H
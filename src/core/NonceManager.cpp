@@ -0,0 +1,61 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "NonceManager.h"
+
+bool NonceManager::reserve(std::string address, uint64_t count, uint64_t &first) {
+  boost::algorithm::to_lower(address);
+  // The lock is held while fetching, so concurrent reservations don't overlap
+  this->nonceLock.lock();
+  uint64_t chainNonce;
+  if (!API::getPendingNonce(address, chainNonce)) {
+    this->nonceLock.unlock();
+    return false;
+  }
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  NonceEntry &entry = this->nextNonces.emplace(address, NonceEntry{chainNonce, false, now}).first->second;
+  if (entry.next <= chainNonce) {
+    entry.ahead = false;
+  } else if (!entry.ahead) {
+    entry.ahead = true;
+    entry.aheadSince = now;
+  } else if (now - entry.aheadSince > this->staleAfter) {
+    // The chain never caught up, so the nonces in between were lost
+    Utils::logToDebug("Local nonce of " + address + " was stale ("
+      + std::to_string(entry.next) + " > " + std::to_string(chainNonce) + "), resyncing");
+    entry.next = chainNonce;
+    entry.ahead = false;
+  }
+  first = std::max(entry.next, chainNonce);
+  entry.next = first + count;
+  this->nonceLock.unlock();
+  return true;
+}
+
+bool NonceManager::release(std::string address, uint64_t first, uint64_t count, uint64_t firstUnused) {
+  boost::algorithm::to_lower(address);
+  if (firstUnused >= first + count) { return true; }
+  this->nonceLock.lock();
+  auto it = this->nextNonces.find(address);
+  bool ret = (it != this->nextNonces.end() && it->second.next == first + count);
+  if (ret) { it->second.next = std::max(first, firstUnused); }
+  this->nonceLock.unlock();
+  return ret;
+}
+
+void NonceManager::reset(std::string address) {
+  boost::algorithm::to_lower(address);
+  this->nonceLock.lock();
+  if (address.empty()) {
+    this->nextNonces.clear();
+  } else {
+    this->nextNonces.erase(address);
+  }
+  this->nonceLock.unlock();
+}
+
+void NonceManager::setStaleAfter(uint64_t seconds) {
+  this->nonceLock.lock();
+  this->staleAfter = std::chrono::seconds(seconds);
+  this->nonceLock.unlock();
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef NONCEMANAGER_H
+#define NONCEMANAGER_H
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <boost/algorithm/string.hpp>
+
+#include <network/API.h>
+
+/**
+ * Local nonce allocator for Accounts sending several transactions at once.
+ * Nonces are reserved in consecutive ranges, starting from whichever is
+ * higher: the next local nonce or the Account's pending transaction count
+ * on the chain (one eth_getTransactionCount per reservation).
+ * After sending, the owner of a range reconciles it, so nonces that
+ * weren't used can be handed out again.
+ * If the local nonce stays ahead of the chain for longer than staleAfter
+ * (e.g. a transaction was dropped from the mempool), it's taken as stale
+ * and the chain's nonce is used again, so the gap doesn't block every
+ * later transaction.
+ */
+class NonceManager {
+  private:
+    // Next free nonce for an Account, and since when it's been ahead of the chain.
+    typedef struct NonceEntry {
+      uint64_t next;
+      bool ahead;
+      std::chrono::steady_clock::time_point aheadSince;
+    } NonceEntry;
+
+    // Entries for each Account (lowercase address).
+    std::map<std::string, NonceEntry> nextNonces;
+    std::mutex nonceLock;
+
+    // How long the local nonce can be ahead of the chain before it's dropped.
+    std::chrono::seconds staleAfter = std::chrono::seconds(120);
+
+  public:
+    /**
+     * Reserve count consecutive nonces for an Account.
+     * Returns false if the chain's nonce couldn't be fetched,
+     * otherwise first is set to the first reserved nonce.
+     */
+    bool reserve(std::string address, uint64_t count, uint64_t &first);
+
+    /**
+     * Give back the unused end of a reserved range, i.e. everything from
+     * firstUnused up to first + count. Only works if nothing was reserved
+     * after the range in the meantime, as those nonces are already taken.
+     * Returns true if the unused nonces were given back (or there were none),
+     * false if they must still be used (e.g. by cancel transactions).
+     */
+    bool release(std::string address, uint64_t first, uint64_t count, uint64_t firstUnused);
+
+    /**
+     * Forget the local nonces for an Account, or for all of them, so the
+     * next reservation starts from the chain's. Should be called when
+     * sending fails, as the chain is the only source of truth left.
+     */
+    void reset(std::string address = "");
+
+    // Set how long the local nonce can be ahead of the chain, in seconds.
+    void setStaleAfter(uint64_t seconds);
+};
+
+#endif  // NONCEMANAGER_H
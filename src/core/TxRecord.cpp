@@ -0,0 +1,198 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "TxRecord.h"
+
+// Flags packed into a single field of the record.
+enum TxRecordFlags {
+  TX_CREATION = 1,
+  TX_CONFIRMED = 2,
+  TX_INVALID = 4,
+  TX_UNSIGNED = 8
+};
+
+// Decode all fields but humanDate from an RLP list.
+static bool decodeFields(const dev::RLP &rlp, TxData &tx) {
+  if (!rlp.isList() || rlp.itemCount() != 17) { return false; }
+  unsigned flags = rlp[1].toInt<unsigned>();
+  tx.operation = rlp[0].toString();
+  tx.type = (flags & TX_CREATION) ? "creation" : "message";
+  tx.hex = dev::toHex(rlp[2].toBytes());
+  tx.hash = dev::toHex(rlp[3].toBytes());
+  tx.to = dev::toHex(rlp[4].toBytes());
+  tx.from = (flags & TX_UNSIGNED) ? "<unsigned>" : dev::toHex(rlp[5].toBytes());
+  tx.creates = dev::toHex(rlp[6].toBytes());
+  tx.code = dev::toHex(rlp[7].toBytes());
+  tx.data = dev::toHex(rlp[8].toBytes());
+  u256 value = rlp[9].toInt<u256>();
+  tx.value = Utils::weiToFixedPoint(boost::lexical_cast<std::string>(value), 18) + " AVAX";
+  tx.nonce = boost::lexical_cast<std::string>(rlp[10].toInt<u256>());
+  tx.gas = boost::lexical_cast<std::string>(rlp[11].toInt<u256>());
+  u256 gasPrice = rlp[12].toInt<u256>();
+  tx.price = dev::eth::formatBalance(gasPrice) + " ("
+    + boost::lexical_cast<std::string>(gasPrice) + " wei)";
+  tx.v = rlp[13].toString();
+  tx.r = dev::toHex(rlp[14].toBytes());
+  tx.s = dev::toHex(rlp[15].toBytes());
+  tx.unixDate = rlp[16].toInt<uint64_t>();
+  tx.confirmed = (flags & TX_CONFIRMED);
+  tx.invalid = (flags & TX_INVALID);
+  return true;
+}
+
+bool TxRecord::isLegacy(const std::string &record) {
+  return (!record.empty() && record[0] == '{');
+}
+
+std::string TxRecord::encode(const TxData &tx) {
+  try {
+    if (tx.type != "creation" && tx.type != "message") { return ""; }
+    unsigned flags = 0;
+    if (tx.type == "creation") { flags |= TX_CREATION; }
+    if (tx.confirmed) { flags |= TX_CONFIRMED; }
+    if (tx.invalid) { flags |= TX_INVALID; }
+    if (tx.from == "<unsigned>") { flags |= TX_UNSIGNED; }
+
+    // Value is "<amount> AVAX", price is "<formatted> (<wei> wei)"
+    const std::string avaxSuffix = " AVAX";
+    if (tx.value.size() <= avaxSuffix.size() ||
+      tx.value.compare(tx.value.size() - avaxSuffix.size(), avaxSuffix.size(), avaxSuffix) != 0
+    ) {
+      return "";
+    }
+    std::string valueWei = Utils::fixedPointToWei(tx.value.substr(0, tx.value.size() - avaxSuffix.size()), 18);
+    size_t priceStart = tx.price.rfind(" (");
+    size_t priceEnd = tx.price.rfind(" wei)");
+    if (valueWei.empty() || priceStart == std::string::npos ||
+      priceEnd == std::string::npos || priceEnd < priceStart
+    ) {
+      return "";
+    }
+    std::string priceWei = tx.price.substr(priceStart + 2, priceEnd - priceStart - 2);
+
+    dev::RLPStream rlp(17);
+    rlp << tx.operation << flags
+      << dev::fromHex(tx.hex, dev::WhenError::Throw)
+      << dev::fromHex(tx.hash, dev::WhenError::Throw)
+      << dev::fromHex(tx.to, dev::WhenError::Throw)
+      << ((flags & TX_UNSIGNED) ? dev::bytes() : dev::fromHex(tx.from, dev::WhenError::Throw))
+      << dev::fromHex(tx.creates, dev::WhenError::Throw)
+      << dev::fromHex(tx.code, dev::WhenError::Throw)
+      << dev::fromHex(tx.data, dev::WhenError::Throw)
+      << u256(valueWei) << u256(tx.nonce) << u256(tx.gas) << u256(priceWei)
+      << tx.v
+      << dev::fromHex(tx.r, dev::WhenError::Throw)
+      << dev::fromHex(tx.s, dev::WhenError::Throw)
+      << u256(tx.unixDate);
+    std::string ret = std::string(1, TxRecord::version) + dev::asString(rlp.out());
+
+    // Make sure nothing is lost (e.g. legacy rows with uppercase hex or odd number formats)
+    TxData check;
+    if (!decodeFields(dev::RLP(ret.substr(1)), check)) { return ""; }
+    check.humanDate = tx.humanDate;
+    if (toJSON(check) != toJSON(tx)) { return ""; }
+    return ret;
+  } catch (std::exception &e) {
+    return "";
+  }
+}
+
+bool TxRecord::decode(const std::string &record, TxData &tx) {
+  try {
+    if (record.empty()) { return false; }
+    if (isLegacy(record)) {
+      tx = fromJSON(json::parse(record));
+      return true;
+    }
+    if (record[0] != TxRecord::version) { return false; }
+    if (!decodeFields(dev::RLP(record.substr(1)), tx)) { return false; }
+    tx.humanDate = formatDate(tx.unixDate);
+    return true;
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("Invalid tx history record: ") + e.what());
+    return false;
+  }
+}
+
+json TxRecord::toJSON(const TxData &tx) {
+  json ret;
+  ret["operation"] = tx.operation;
+  ret["hex"] = tx.hex;
+  ret["type"] = tx.type;
+  ret["code"] = tx.code;
+  ret["to"] = tx.to;
+  ret["from"] = tx.from;
+  ret["data"] = tx.data;
+  ret["creates"] = tx.creates;
+  ret["value"] = tx.value;
+  ret["nonce"] = tx.nonce;
+  ret["gas"] = tx.gas;
+  ret["price"] = tx.price;
+  ret["hash"] = tx.hash;
+  ret["v"] = tx.v;
+  ret["r"] = tx.r;
+  ret["s"] = tx.s;
+  ret["humanDate"] = tx.humanDate;
+  ret["unixDate"] = tx.unixDate;
+  ret["confirmed"] = tx.confirmed;
+  ret["invalid"] = tx.invalid;
+  return ret;
+}
+
+TxData TxRecord::fromJSON(const json &txJson) {
+  TxData ret;
+  ret.operation = txJson["operation"].get<std::string>();
+  ret.hex = txJson["hex"].get<std::string>();
+  ret.type = txJson["type"].get<std::string>();
+  ret.code = txJson["code"].get<std::string>();
+  ret.to = txJson["to"].get<std::string>();
+  ret.from = txJson["from"].get<std::string>();
+  ret.data = txJson["data"].get<std::string>();
+  ret.creates = txJson["creates"].get<std::string>();
+  ret.value = txJson["value"].get<std::string>();
+  ret.nonce = txJson["nonce"].get<std::string>();
+  ret.gas = txJson["gas"].get<std::string>();
+  ret.price = txJson["price"].get<std::string>();
+  ret.hash = txJson["hash"].get<std::string>();
+  ret.v = txJson["v"].get<std::string>();
+  ret.r = txJson["r"].get<std::string>();
+  ret.s = txJson["s"].get<std::string>();
+  ret.humanDate = txJson["humanDate"].get<std::string>();
+  ret.unixDate = txJson["unixDate"].get<uint64_t>();
+  ret.confirmed = txJson["confirmed"].get<bool>();
+  ret.invalid = txJson["invalid"].get<bool>();
+  return ret;
+}
+
+// Append a number to a string as 8 big-endian bytes.
+static void appendBigEndian(std::string &str, uint64_t num) {
+  for (int i = 7; i >= 0; i--) { str += char((num >> (i * 8)) & 0xFF); }
+}
+
+std::string TxRecord::indexKey(const TxData &tx) {
+  uint64_t nonce = 0;
+  try {
+    nonce = boost::lexical_cast<uint64_t>(tx.nonce);
+  } catch (std::exception &e) {}
+  std::string ret = indexKey(tx.unixDate);
+  appendBigEndian(ret, nonce);
+  return ret + tx.hash;
+}
+
+std::string TxRecord::indexKey(uint64_t unixDate) {
+  std::string ret;
+  appendBigEndian(ret, unixDate);
+  return ret;
+}
+
+std::string TxRecord::hashFromIndexKey(const std::string &key) {
+  return (key.size() > 16) ? key.substr(16) : "";
+}
+
+std::string TxRecord::formatDate(uint64_t unixDate) {
+  std::time_t t = unixDate;
+  std::tm tm = *std::localtime(&t);
+  std::stringstream timestream;
+  timestream << std::put_time(&tm, "%d-%m-%Y %H-%M-%S");
+  return timestream.str();
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef TXRECORD_H
+#define TXRECORD_H
+
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <core/Utils.h>
+
+#include <lib/devcore/CommonData.h>
+#include <lib/devcore/RLP.h>
+#include <lib/ethcore/Common.h>
+#include <lib/nlohmann_json/json.hpp>
+
+// For convenience.
+using json = nlohmann::json;
+
+// Filters for a tx history page query. Empty/zero fields match anything.
+typedef struct TxHistoryFilter {
+  std::string operation;  // Exact operation name (e.g. "Send AVAX")
+  uint64_t fromDate = 0;  // Only txs made at or after this unix time
+  uint64_t toDate = 0;    // Only txs made before this unix time
+} TxHistoryFilter;
+
+// A page of tx history (newest first) and the cursor for the next one.
+typedef struct TxHistoryPage {
+  std::vector<TxData> txs;
+  std::string nextCursor;
+  bool hasMore = false;
+} TxHistoryPage;
+
+/**
+ * Namespace for the binary storage format of tx history records.
+ * A record is a version byte followed by an RLP list with the raw values
+ * (hashes/addresses/data as bytes, amounts as u256). Formatted strings
+ * (value in AVAX, gas price, human date) are rebuilt when decoding.
+ * Legacy records are JSON objects, which always start with '{'.
+ */
+namespace TxRecord {
+  // Current record version.
+  const char version = 0x01;
+
+  // Check if a stored record is in the legacy JSON format.
+  bool isLegacy(const std::string &record);
+
+  /**
+   * Encode a transaction as a binary record.
+   * Returns an empty string if the transaction can't be stored losslessly
+   * (e.g. a field has an unexpected format), callers should store it as
+   * JSON instead.
+   */
+  std::string encode(const TxData &tx);
+
+  // Decode a stored record (binary or legacy JSON). Returns false if it's invalid.
+  bool decode(const std::string &record, TxData &tx);
+
+  // Convert a transaction to/from its JSON object.
+  json toJSON(const TxData &tx);
+  TxData fromJSON(const json &txJson);
+
+  /**
+   * Get a tx's key in the history index: big-endian unixDate and nonce,
+   * followed by the tx hash, so keys sort by time.
+   * The date-only version is a bound for range queries.
+   */
+  std::string indexKey(const TxData &tx);
+  std::string indexKey(uint64_t unixDate);
+
+  // Get the tx hash from an index key.
+  std::string hashFromIndexKey(const std::string &key);
+
+  // Format a unix timestamp the same way as the "humanDate" field, in local time.
+  std::string formatDate(uint64_t unixDate);
+};
+
+#endif  // TXRECORD_H
@@ -232,6 +232,14 @@ std::string Utils::addressFromHex(std::string hex) {
   return ret;
 }
 
+// Get the value of a single hex char, throwing if it isn't one.
+static unsigned char hexNibble(char c) {
+  if (c >= '0' && c <= '9') { return c - '0'; }
+  if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+  if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+  throw std::invalid_argument(std::string("Invalid hex char: ") + c);
+}
+
 std::string Utils::bytesFromHex(std::string hex) {
   std::string ret, offset, len, hexStr;
   if (hex.substr(0, 2) == "0x") { hex = hex.substr(2); } // Remove the "0x"
@@ -250,10 +258,10 @@ std::string Utils::bytesFromHex(std::string hex) {
   // Parse the hex string byte by byte (every two chars)
   uint64_t offsetU256 = boost::lexical_cast<HexTo<uint64_t>>("0x" + offset) * 2;
   uint64_t lengthU256 = boost::lexical_cast<HexTo<uint64_t>>("0x" + len) * 2;
+  if (lengthU256 > hexStr.size()) { throw std::out_of_range("bytesFromHex: length past the data"); }
+  ret.reserve(lengthU256 / 2);
   for (uint64_t i = 0; i < lengthU256; i += 2) {
-    unsigned int hexInt = boost::lexical_cast<HexTo<unsigned int>>("0x" + hexStr.substr(i, 2));
-    unsigned char hexChar = hexInt;
-    ret += hexChar;
+    ret += char((hexNibble(hexStr[i]) << 4) | hexNibble(hexStr[i + 1]));
   }
   return ret;
 }
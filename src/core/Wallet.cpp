@@ -63,12 +63,15 @@ bool Wallet::load(boost::filesystem::path folder, std::string pass) {
 }
 
 void Wallet::close() {
+  cancelTrackedTxs();
   this->currentAccount = std::make_pair("", "");
   this->currentAccountHistory.clear();
   this->accounts.clear();
   this->ledgerAccounts.clear();
   this->passHash = bytesSec();
   this->passSalt = h256();
+  this->keySession.lockAll();
+  this->nonces.reset();
   this->km = KeyManager();
   Utils::walletFolderPath = "";
 }
@@ -83,13 +86,20 @@ bool Wallet::auth(std::string pass) {
 }
 
 bool Wallet::loadTokenDB() {
+  // The store can't use the database while it's being reopened
+  PriceStore::setTable(DBTable());
   if (this->db.isTokenDBOpen()) { this->db.closeTokenDB(); }
-  return this->db.openTokenDB();
+  if (!this->db.openTokenDB()) { return false; }
+  PriceStore::setTable(this->getPriceTable());
+  return true;
 }
 
 bool Wallet::loadHistoryDB(std::string address) {
+  cancelTrackedTxs();
   if (this->db.isHistoryDBOpen()) { this->db.closeHistoryDB(); }
-  return this->db.openHistoryDB(address);
+  if (!this->db.openHistoryDB(address)) { return false; }
+  upgradeTxHistory();
+  return true;
 }
 
 bool Wallet::loadLedgerDB() {
@@ -113,10 +123,14 @@ bool Wallet::loadConfigDB() {
 }
 
 void Wallet::closeTokenDB() {
+  PortfolioService::stop();
+  SwapRouter::stop();
+  PriceStore::setTable(DBTable());
   if (this->db.isTokenDBOpen()) { this->db.closeTokenDB(); }
 }
 
 void Wallet::closeHistoryDB() {
+  cancelTrackedTxs();
   if (this->db.isHistoryDBOpen()) { this->db.closeHistoryDB(); }
 }
 
@@ -138,7 +152,7 @@ void Wallet::closeConfigDB() {
 
 void Wallet::loadARC20Tokens() {
   this->ARC20Tokens.clear();
-  std::vector<std::string> tokenJsonList = this->db.getAllTokenDBValues();
+  std::vector<std::string> tokenJsonList = this->db.tokenTable().getAllValues();
   for (std::string tokenJson : tokenJsonList) {
     ARC20Token token;
     json tokenData = json::parse(tokenJson);
@@ -151,29 +165,99 @@ void Wallet::loadARC20Tokens() {
   }
 }
 
+// Metadata cache entry for a token, or for an address that isn't one.
+static json tokenMetaJson(const ARC20Token *token) {
+  json meta;
+  meta["isToken"] = (token != NULL);
+  if (token != NULL) {
+    meta["address"] = token->address;
+    meta["symbol"] = token->symbol;
+    meta["name"] = token->name;
+    meta["decimals"] = token->decimals;
+    meta["avaxPairContract"] = token->avaxPairContract;
+  } else {
+    meta["checked"] = uint64_t(std::time(nullptr));
+  }
+  return meta;
+}
+
 bool Wallet::addARC20Token(
   std::string address, std::string symbol, std::string name,
   int decimals, std::string avaxPairContract
 ) {
-  json token;
-  token["address"] = address;
-  token["symbol"] = symbol;
-  token["name"] = name;
-  token["decimals"] = decimals;
-  token["avaxPairContract"] = avaxPairContract;
-  bool success = this->db.putTokenDBValue(address, token.dump());
+  ARC20Token token;
+  token.address = address;
+  token.symbol = symbol;
+  token.name = name;
+  token.decimals = decimals;
+  token.avaxPairContract = avaxPairContract;
+  return addARC20Tokens({token});
+}
+
+bool Wallet::addARC20Tokens(std::vector<ARC20Token> tokens) {
+  // Registered tokens are also cached, so looking them up again is free
+  DBTable tokenTable = this->db.tokenTable();
+  DBTable metaTable = tokenTable.subTable("meta");
+  DBBatch batch;
+  for (ARC20Token &token : tokens) {
+    json tokenJson;
+    tokenJson["address"] = token.address;
+    tokenJson["symbol"] = token.symbol;
+    tokenJson["name"] = token.name;
+    tokenJson["decimals"] = token.decimals;
+    tokenJson["avaxPairContract"] = token.avaxPairContract;
+    batch.putValue(tokenTable, token.address, tokenJson.dump());
+    batch.putValue(metaTable, Utils::toCamelCaseAddress(token.address), tokenMetaJson(&token).dump());
+  }
+  bool success = tokenTable.write(batch);
   if (success) { loadARC20Tokens(); }
   return success;
 }
 
 bool Wallet::removeARC20Token(std::string address) {
-  bool success = this->db.deleteTokenDBValue(address);
+  bool success = this->db.tokenTable().deleteValue(address);
   if (success) { loadARC20Tokens(); }
   return success;
 }
 
 bool Wallet::ARC20TokenWasAdded(std::string address) {
-  return this->db.tokenDBKeyExists(address);
+  return this->db.tokenTable().keyExists(address);
+}
+
+bool Wallet::getARC20TokenMeta(std::string address, ARC20Token &token, bool &isToken) {
+  std::string value;
+  if (!this->db.tokenTable().subTable("meta").getValue(Utils::toCamelCaseAddress(address), value)) {
+    return false;
+  }
+  try {
+    json meta = json::parse(value);
+    isToken = meta["isToken"].get<bool>();
+    if (!isToken) {
+      // Contracts can still be deployed there later, so this doesn't last forever
+      return (uint64_t(std::time(nullptr)) < meta["checked"].get<uint64_t>() + 86400);
+    }
+    token.address = meta["address"].get<std::string>();
+    token.symbol = meta["symbol"].get<std::string>();
+    token.name = meta["name"].get<std::string>();
+    token.decimals = meta["decimals"].get<int>();
+    token.avaxPairContract = meta["avaxPairContract"].get<std::string>();
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("Token metadata ERROR: ") + e.what());
+    return false;
+  }
+  return true;
+}
+
+bool Wallet::saveARC20TokenMeta(std::vector<ARC20Token> tokens, std::vector<std::string> nonTokens) {
+  DBTable metaTable = this->db.tokenTable().subTable("meta");
+  DBBatch batch;
+  for (ARC20Token &token : tokens) {
+    batch.putValue(metaTable, Utils::toCamelCaseAddress(token.address), tokenMetaJson(&token).dump());
+  }
+  for (std::string &address : nonTokens) {
+    batch.putValue(metaTable, Utils::toCamelCaseAddress(address), tokenMetaJson(NULL).dump());
+  }
+  return metaTable.write(batch);
 }
 
 void Wallet::loadAccounts() {
@@ -195,33 +279,52 @@ void Wallet::loadAccounts() {
 std::pair<std::string, std::string> Wallet::createAccount(
   std::string &seed, int64_t index, std::string name, std::string &pass
 ) {
+  std::vector<std::pair<std::string, std::string>> ret = createAccounts(seed, index, {name}, pass);
+  return (!ret.empty()) ? ret[0] : std::make_pair("", "");
+}
+
+std::vector<std::pair<std::string, std::string>> Wallet::createAccounts(
+  std::string &seed, int64_t start, std::vector<std::string> names, std::string &pass
+) {
+  std::vector<std::pair<std::string, std::string>> ret;
   bip3x::Bip39Mnemonic::MnemonicResult mnemonic;
   if (!seed.empty()) { // Using a foreign seed
     mnemonic.raw = seed;
   } else {  // Using the Wallet's own seed
     std::pair<bool,std::string> seedSuccess = BIP39::loadEncryptedMnemonic(mnemonic, pass);
-    if (!seedSuccess.first) { return std::make_pair("", ""); }
+    if (!seedSuccess.first) { return ret; }
+  }
+  std::vector<std::pair<Secret, std::string>> keys;
+  bip3x::HDKey parentKey = BIP39::createParentKey(mnemonic.raw);
+  BIP39::deriveAccounts(parentKey, start, names.size(), [&](int64_t index, const KeyPair &k){
+    std::string name = names[index - start];
+    keys.push_back(std::make_pair(k.secret(), name));
+    ret.push_back(std::make_pair(k.address().hex(), name));
+    return true;
+  });
+  parentKey.clear();
+  try {
+    this->km.import(keys, pass, "");
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("Error creating accounts: ") + e.what());
+    ret.clear();
   }
-  std::string indexStr = boost::lexical_cast<std::string>(index);
-  bip3x::HDKey keyPair = BIP39::createKey(mnemonic.raw, "m/44'/60'/0'/0/" + indexStr);
-  KeyPair k(Secret::frombip3x(keyPair.privateKey));
-  h128 u = this->km.import(k.secret(), name, pass, "");
   loadAccounts();
-  return std::make_pair(k.address().hex(), name);
+  return ret;
 }
 
 bool Wallet::importLedgerAccount(std::string address, std::string path) {
   json ledgerAccount;
   ledgerAccount["address"] = address;
   ledgerAccount["index"] = path;
-  bool success = this->db.putLedgerDBValue(address, ledgerAccount.dump());
+  bool success = this->db.ledgerTable().putValue(address, ledgerAccount.dump());
   if (success) { loadLedgerDB(); }
   return success;
 }
 
 std::vector<ledger::account> Wallet::getAllLedgerAccounts() {
   std::vector<ledger::account> ret;
-  auto accountsList = this->db.getAllLedgerDBValues();
+  auto accountsList = this->db.ledgerTable().getAllValues();
   for (auto account : accountsList) {
     auto accountJson = json::parse(account);
     ret.push_back({accountJson["address"], accountJson["index"]});
@@ -230,7 +333,7 @@ std::vector<ledger::account> Wallet::getAllLedgerAccounts() {
 }
 
 bool Wallet::deleteLedgerAccount(std::string address) {
-  bool success = this->db.deleteLedgerDBValue(address);
+  bool success = this->db.ledgerTable().deleteValue(address);
   return success;
 }
 
@@ -248,7 +351,7 @@ bool Wallet::accountExists(std::string address) {
 }
 
 bool Wallet::ledgerAccountExists(std::string address) {
-  return this->db.ledgerDBKeyExists(address);
+  return this->db.ledgerTable().keyExists(address);
 }
 
 void Wallet::setCurrentAccount(std::string address) {
@@ -270,6 +373,18 @@ Address Wallet::userToAddress(std::string const& input) {
   return Address();
 }
 
+bool Wallet::unlockAccount(
+  std::string address, std::string pass, unsigned seconds, unsigned maxSignatures
+) {
+  Secret s = getSecret(address, pass);
+  if (!s) { return false; }
+  return this->keySession.unlock(KeyPair(s).address(), s, pass, seconds, maxSignatures);
+}
+
+void Wallet::lockAccounts() {
+  this->keySession.lockAll();
+}
+
 Secret Wallet::getSecret(std::string const& address, std::string pass) {
   if (h128 u = fromUUID(address)) {
     return Secret(this->km.store().secret(u, [&](){ return pass; }, false));
@@ -295,7 +410,7 @@ Secret Wallet::getSecret(std::string const& address, std::string pass) {
 
 json Wallet::getRegisteredApps() {
   json appList = json::array();
-  std::vector<std::string> appJsonList = this->db.getAllAppDBValues();
+  std::vector<std::string> appJsonList = this->db.appTable().getAllValues();
   for (std::string appJson : appJsonList) {
     appList.push_back(json::parse(appJson));
   }
@@ -303,7 +418,7 @@ json Wallet::getRegisteredApps() {
 }
 
 bool Wallet::appIsRegistered(std::string folder) {
-  return this->db.appDBKeyExists(folder);
+  return this->db.appTable().keyExists(folder);
 }
 
 bool Wallet::registerApp(
@@ -317,16 +432,16 @@ bool Wallet::registerApp(
   app["major"] = major;
   app["minor"] = minor;
   app["patch"] = patch;
-  return this->db.putAppDBValue(folder, app.dump());
+  return this->db.appTable().putValue(folder, app.dump());
 }
 
 bool Wallet::unregisterApp(std::string folder) {
-  return this->db.deleteAppDBValue(folder);
+  return this->db.appTable().deleteValue(folder);
 }
 
 std::map<std::string, std::string> Wallet::getContacts() {
   std::map<std::string, std::string> ret;
-  std::vector<std::string> contacts = this->db.getAllAddressDBValues();
+  std::vector<std::string> contacts = this->db.addressTable().getAllValues();
   for (std::string contact : contacts) {
     json contactJson = json::parse(contact);
     ret.emplace(contactJson["address"], contactJson["name"]);
@@ -338,11 +453,11 @@ bool Wallet::addContact(std::string address, std::string name) {
   json contact = json::object();
   contact["address"] = address;
   contact["name"] = name;
-  return this->db.putAddressDBValue(address, contact.dump());
+  return this->db.addressTable().putValue(address, contact.dump());
 }
 
 bool Wallet::removeContact(std::string address) {
-  return this->db.deleteAddressDBValue(address);
+  return this->db.addressTable().deleteValue(address);
 }
 
 int Wallet::importContacts(std::string file) {
@@ -350,9 +465,12 @@ int Wallet::importContacts(std::string file) {
   boost::filesystem::path filePath = file;
   if (!boost::filesystem::exists(filePath)) { return ret; }
   json contacts = json::parse(Utils::readJSONFile(filePath))["contacts"];
+  std::vector<std::pair<std::string, std::string>> values;
   for (json contact : contacts) {
-    ret += this->db.putAddressDBValue(contact["address"], contact.dump());
+    values.push_back(std::make_pair(contact["address"].get<std::string>(), contact.dump()));
   }
+  // All contacts are written at once, or none at all
+  if (this->db.addressTable().putValues(values)) { ret = values.size(); }
   return ret;
 }
 
@@ -362,7 +480,7 @@ int Wallet::exportContacts(std::string file) {
   if (!boost::filesystem::exists(filePath.parent_path())) {
     boost::filesystem::create_directories(filePath.parent_path());
   }
-  std::vector<std::string> contacts = this->db.getAllAddressDBValues();
+  std::vector<std::string> contacts = this->db.addressTable().getAllValues();
   json contactObj = json::object();
   contactObj["contacts"] = json::array();
   for (std::string contact : contacts) {
@@ -395,12 +513,8 @@ TransactionSkeleton Wallet::buildTransaction(
   return txSkel;
 }
 
-std::string Wallet::signTransaction(TransactionSkeleton txSkel, std::string pass) {
-  //std::cout << "Sign from: " << txSkel.from << std::endl;
-  //std::cout << "Password: " << pass << std::endl;
-  Secret s = getSecret("0x" + boost::lexical_cast<std::string>(txSkel.from), pass);
+std::string Wallet::signWithSecret(TransactionSkeleton txSkel, const Secret &s) {
   std::stringstream txHexBuffer;
-
   try {
     TransactionBase t = TransactionBase(txSkel);
     t.setNonce(txSkel.nonce);
@@ -410,10 +524,40 @@ std::string Wallet::signTransaction(TransactionSkeleton txSkel, std::string pass
     Utils::logToDebug(std::string("Invalid Transaction: ") + ex.what());
     return "";
   }
-
   return txHexBuffer.str();
 }
 
+std::vector<std::string> Wallet::signWithSecret(
+  std::vector<TransactionSkeleton> txSkels, const Secret &s
+) {
+  std::vector<std::string> ret(txSkels.size());
+  std::atomic<size_t> next(0);
+  size_t threads = std::min<size_t>(
+    std::max(1u, std::thread::hardware_concurrency()), txSkels.size()
+  );
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&]{
+      for (size_t i = next++; i < txSkels.size(); i = next++) {
+        ret[i] = this->signWithSecret(txSkels[i], s);
+      }
+    });
+  }
+  for (std::thread &w : workers) { w.join(); }
+  return ret;
+}
+
+std::string Wallet::signTransaction(TransactionSkeleton txSkel, std::string pass) {
+  //std::cout << "Sign from: " << txSkel.from << std::endl;
+  //std::cout << "Password: " << pass << std::endl;
+  // A wrong password misses the session and fails decrypting the key file
+  Secret s;
+  if (!this->keySession.useSecret(txSkel.from, pass, s)) {
+    s = getSecret("0x" + boost::lexical_cast<std::string>(txSkel.from), pass);
+  }
+  return signWithSecret(txSkel, s);
+}
+
 json Wallet::sendTransaction(std::string txidHex, std::string operation) {
   // Send the transaction
   json transactionResult = json::parse(API::broadcastTx(txidHex));
@@ -427,124 +571,340 @@ json Wallet::sendTransaction(std::string txidHex, std::string operation) {
     TxData txData = Utils::decodeRawTransaction(txidHex);
     txData.operation = operation;
     saveTxToHistory(txData);
+    trackTx(txData);
   }
   return transactionResult;
 }
 
+std::vector<json> Wallet::sendTransactionBatch(
+  std::vector<TransactionSkeleton> txSkels, std::vector<std::string> operations, std::string pass
+) {
+  size_t count = txSkels.size();
+  auto error = [](std::string msg){
+    json err;
+    err["jsonrpc"] = "2.0";
+    err["error"]["code"] = -32603;
+    err["error"]["message"] = msg;
+    return err;
+  };
+  if (count == 0) { return std::vector<json>(); }
+  Address from = txSkels[0].from;
+  std::string fromStr = "0x" + boost::lexical_cast<std::string>(from);
+  for (TransactionSkeleton &txSkel : txSkels) {
+    if (txSkel.from != from) { return std::vector<json>(count, error("All transactions must be from the same Account")); }
+  }
+
+  // Decrypt the key only once for the whole batch
+  Secret s;
+  if (!this->keySession.useSecret(from, pass, s)) { s = getSecret(fromStr, pass); }
+  if (!s) { return std::vector<json>(count, error("Could not decrypt the Account's key")); }
+  uint64_t first;
+  if (!this->nonces.reserve(fromStr, count, first)) {
+    return std::vector<json>(count, error("Could not get the Account's nonce"));
+  }
+  for (size_t i = 0; i < count; i++) { txSkels[i].nonce = first + i; }
+
+  // Broadcast signed transactions as one batch, skipping the ones that couldn't be signed
+  auto broadcast = [&](std::vector<std::string> signedTxs){
+    std::vector<json> ret(signedTxs.size(), error("Invalid transaction"));
+    std::vector<std::string> toSend;
+    std::vector<size_t> sentIdx;
+    for (size_t i = 0; i < signedTxs.size(); i++) {
+      if (!signedTxs[i].empty()) { toSend.push_back(signedTxs[i]); sentIdx.push_back(i); }
+    }
+    if (!toSend.empty()) {
+      std::vector<json> resp = API::broadcastTxs(toSend);
+      for (size_t i = 0; i < sentIdx.size(); i++) { ret[sentIdx[i]] = resp[i]; }
+    }
+    return ret;
+  };
+  std::vector<std::string> signedTxs = signWithSecret(txSkels, s);
+  std::vector<json> ret = broadcast(signedTxs);
+
+  // A failed nonce blocks every later one, so failures before the last
+  // accepted transaction are retried once as they are (errors can be transient)
+  int64_t lastOk = -1;
+  for (size_t i = 0; i < count; i++) { if (ret[i].contains("result")) { lastOk = i; } }
+  std::vector<size_t> retries;
+  for (int64_t i = 0; i < lastOk; i++) {
+    if (!ret[i].contains("result") && !signedTxs[i].empty()) { retries.push_back(i); }
+  }
+  if (!retries.empty()) {
+    std::vector<std::string> retryTxs;
+    for (size_t i : retries) { retryTxs.push_back(signedTxs[i]); }
+    std::vector<json> retryResp = broadcast(retryTxs);
+    for (size_t i = 0; i < retries.size(); i++) {
+      if (retryResp[i].contains("result")) { ret[retries[i]] = retryResp[i]; }
+    }
+  }
+
+  // Give back the unused nonces at the end if possible, and fill any
+  // remaining gaps with 0-value transfers to self
+  bool released = this->nonces.release(fromStr, first, count, first + lastOk + 1);
+  // Nothing got through, so start over from the chain's nonce next time
+  if (lastOk < 0 && released) { this->nonces.reset(fromStr); }
+  std::vector<size_t> gaps;
+  std::vector<TransactionSkeleton> cancelSkels;
+  for (size_t i = 0; i < count; i++) {
+    if (ret[i].contains("result") || (int64_t(i) > lastOk && released)) { continue; }
+    TransactionSkeleton cancel;
+    cancel.creation = false;
+    cancel.from = from;
+    cancel.to = from;
+    cancel.value = 0;
+    cancel.nonce = first + i;
+    cancel.gas = 21000;
+    cancel.gasPrice = txSkels[i].gasPrice;
+    cancel.chainId = txSkels[i].chainId;
+    gaps.push_back(i);
+    cancelSkels.push_back(cancel);
+  }
+  std::vector<std::string> cancelTxs;
+  std::vector<json> cancelResp;
+  if (!gaps.empty()) {
+    cancelTxs = signWithSecret(cancelSkels, s);
+    cancelResp = broadcast(cancelTxs);
+    for (size_t i = 0; i < gaps.size(); i++) {
+      if (cancelResp[i].contains("result")) {
+        ret[gaps[i]]["cancelTx"] = cancelResp[i]["result"];
+      } else {
+        // The chain is the only source of truth left, so start over from it next time
+        Utils::logToDebug("Nonce " + boost::lexical_cast<std::string>(first + gaps[i])
+          + " of " + fromStr + " could not be filled: " + cancelResp[i].dump());
+        this->nonces.reset(fromStr);
+      }
+    }
+  }
+
+  // Store everything that was sent in one write
+  std::vector<TxData> sent;
+  for (size_t i = 0; i < count; i++) {
+    if (!ret[i].contains("result")) { continue; }
+    TxData txData = Utils::decodeRawTransaction(signedTxs[i]);
+    txData.operation = (i < operations.size()) ? operations[i] : "";
+    sent.push_back(txData);
+  }
+  for (size_t i = 0; i < gaps.size(); i++) {
+    if (!cancelResp[i].contains("result")) { continue; }
+    TxData txData = Utils::decodeRawTransaction(cancelTxs[i]);
+    txData.operation = "Cancel Transaction";
+    sent.push_back(txData);
+  }
+  if (!sent.empty() && !saveTxsToHistory(sent)) {
+    Utils::logToDebug("Failed to store the sent transactions in history");
+  }
+  for (TxData &txData : sent) { trackTx(txData); }
+  return ret;
+}
+
 json Wallet::txDataToJSON() {
   json transactionsArray;
   for (TxData savedTxData : this->currentAccountHistory) {
-    json savedTransaction;
-    savedTransaction["operation"] = savedTxData.operation;
-    savedTransaction["hex"] = savedTxData.hex;
-    savedTransaction["type"] = savedTxData.type;
-    savedTransaction["code"] = savedTxData.code;
-    savedTransaction["to"] = savedTxData.to;
-    savedTransaction["from"] = savedTxData.from;
-    savedTransaction["data"] = savedTxData.data;
-    savedTransaction["creates"] = savedTxData.creates;
-    savedTransaction["value"] = savedTxData.value;
-    savedTransaction["nonce"] = savedTxData.nonce;
-    savedTransaction["gas"] = savedTxData.gas;
-    savedTransaction["price"] = savedTxData.price;
-    savedTransaction["hash"] = savedTxData.hash;
-    savedTransaction["v"] = savedTxData.v;
-    savedTransaction["r"] = savedTxData.r;
-    savedTransaction["s"] = savedTxData.s;
-    savedTransaction["humanDate"] = savedTxData.humanDate;
-    savedTransaction["unixDate"] = savedTxData.unixDate;
-    savedTransaction["confirmed"] = savedTxData.confirmed;
-    savedTransaction["invalid"] = savedTxData.invalid;
-    transactionsArray.push_back(savedTransaction);
+    transactionsArray.push_back(TxRecord::toJSON(savedTxData));
   }
   return transactionsArray;
 }
 
+void Wallet::upgradeTxHistory() {
+  DBTable history = this->db.historyTable();
+  DBTable index = history.subTable("idx");
+  DBTable meta = history.subTable("meta");
+  if (meta.keyExists("indexed")) { return; }
+
+  // Convert legacy JSON records to the binary format and index every tx,
+  // all in one write, so an interrupted upgrade is just done again later
+  DBBatch batch;
+  history.scan([&](const std::string &key, const std::string &value){
+    TxData txData;
+    if (!TxRecord::decode(value, txData)) { return true; }
+    if (TxRecord::isLegacy(value)) {
+      std::string record = TxRecord::encode(txData);
+      if (!record.empty()) { batch.putValue(history, key, record); }
+    }
+    batch.putValue(index, TxRecord::indexKey(txData), "");
+    return true;
+  }, "", "", false, history.getSnapshot());
+  batch.putValue(meta, "indexed", "1");
+  if (!history.write(batch)) {
+    Utils::logToDebug("Failed to upgrade the tx history database");
+  }
+}
+
 void Wallet::loadTxHistory() {
   this->currentAccountHistory.clear();
-  std::vector<std::string> txData = this->db.getAllHistoryDBValues();
-  for (std::string txStr : txData) {
-    json tx = json::parse(txStr);
+  for (std::string value : this->db.historyTable().getAllValues()) {
     TxData txData;
-    txData.operation = tx["operation"].get<std::string>();
-    txData.hex = tx["hex"].get<std::string>();
-    txData.type = tx["type"].get<std::string>();
-    txData.code = tx["code"].get<std::string>();
-    txData.to = tx["to"].get<std::string>();
-    txData.from = tx["from"].get<std::string>();
-    txData.data = tx["data"].get<std::string>();
-    txData.creates = tx["creates"].get<std::string>();
-    txData.value = tx["value"].get<std::string>();
-    txData.nonce = tx["nonce"].get<std::string>();
-    txData.gas = tx["gas"].get<std::string>();
-    txData.price = tx["price"].get<std::string>();
-    txData.hash = tx["hash"].get<std::string>();
-    txData.v = tx["v"].get<std::string>();
-    txData.r = tx["r"].get<std::string>();
-    txData.s = tx["s"].get<std::string>();
-    txData.humanDate = tx["humanDate"].get<std::string>();
-    txData.unixDate = tx["unixDate"].get<uint64_t>();
-    txData.confirmed = tx["confirmed"].get<bool>();
-    txData.invalid = tx["invalid"].get<bool>();
-    this->currentAccountHistory.push_back(txData);
+    if (TxRecord::decode(value, txData)) { this->currentAccountHistory.push_back(txData); }
   }
 }
 
+TxHistoryPage Wallet::loadTxHistoryPage(std::string cursor, size_t limit, TxHistoryFilter filter) {
+  TxHistoryPage ret;
+  DBTable history = this->db.historyTable();
+  DBTable index = history.subTable("idx");
+  DBSnapshot snapshot = history.getSnapshot();
+
+  // Newest first, so the cursor (last key of the previous page) is the upper bound
+  std::string lower = (filter.fromDate > 0) ? TxRecord::indexKey(filter.fromDate) : "";
+  std::string upper = cursor;
+  if (filter.toDate > 0) {
+    std::string dateKey = TxRecord::indexKey(filter.toDate);
+    if (upper.empty() || dateKey < upper) { upper = dateKey; }
+  }
+  index.scan([&](const std::string &key, const std::string &value){
+    if (ret.txs.size() >= limit) { ret.hasMore = true; return false; }
+    ret.nextCursor = key;
+    std::string record;
+    TxData txData;
+    if (!history.getValue(TxRecord::hashFromIndexKey(key), record, snapshot)) { return true; }
+    if (!TxRecord::decode(record, txData)) { return true; }
+    if (!filter.operation.empty() && txData.operation != filter.operation) { return true; }
+    ret.txs.push_back(txData);
+    return true;
+  }, lower, upper, true, snapshot);
+  return ret;
+}
+
+bool Wallet::getTxFromHistory(std::string txHash, TxData &tx) {
+  std::string record;
+  if (!this->db.historyTable().getValue(txHash, record)) { return false; }
+  return TxRecord::decode(record, tx);
+}
+
 bool Wallet::saveTxToHistory(TxData tx) {
-  json transaction;
-  transaction["operation"] = tx.operation;
-  transaction["hex"] = tx.hex;
-  transaction["type"] = tx.type;
-  transaction["code"] = tx.code;
-  transaction["to"] = tx.to;
-  transaction["from"] = tx.from;
-  transaction["data"] = tx.data;
-  transaction["creates"] = tx.creates;
-  transaction["value"] = tx.value;
-  transaction["nonce"] = tx.nonce;
-  transaction["gas"] = tx.gas;
-  transaction["price"] = tx.price;
-  transaction["hash"] = tx.hash;
-  transaction["v"] = tx.v;
-  transaction["r"] = tx.r;
-  transaction["s"] = tx.s;
-  transaction["humanDate"] = tx.humanDate;
-  transaction["unixDate"] = tx.unixDate;
-  transaction["confirmed"] = tx.confirmed;
-  transaction["invalid"] = tx.invalid;
-  return this->db.putHistoryDBValue(tx.hash, transaction.dump());
+  return saveTxsToHistory({tx});
 }
 
-void Wallet::updateTxStatus(std::string txHash) {
-  TxData tx;
-  for (TxData savedTxData : this->currentAccountHistory) {
-    if (savedTxData.hash == txHash) { tx = savedTxData; break; }
-  }
-  u256 currentBlock = boost::lexical_cast<HexTo<u256>>(API::getCurrentBlock());
-  const auto p1 = std::chrono::system_clock::now();
-  uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(p1.time_since_epoch()).count();
-  json apiAnswer = json::parse(API::getTxStatus(tx.hex));
-  if (apiAnswer.contains("status")) {
-    std::string status = apiAnswer["status"];
-    if (status == "0x1") tx.confirmed = true;
-    if (status == "0x0") {
-      u256 transactionBlock = boost::lexical_cast<HexTo<u256>>(API::getTxBlock(apiAnswer["result"]["blockNumber"]));
-      tx.invalid = (currentBlock > transactionBlock);
+bool Wallet::saveTxsToHistory(std::vector<TxData> txs) {
+  DBTable history = this->db.historyTable();
+  DBTable index = history.subTable("idx");
+  DBBatch batch;
+
+  for (TxData &tx : txs) {
+    // Fall back to JSON if the tx can't be stored losslessly in binary
+    std::string record = TxRecord::encode(tx);
+    if (record.empty()) { record = TxRecord::toJSON(tx).dump(); }
+
+    // Record and index entry are written together, dropping the old entry if the tx moved
+    TxData oldTx;
+    if (getTxFromHistory(tx.hash, oldTx) && TxRecord::indexKey(oldTx) != TxRecord::indexKey(tx)) {
+      batch.deleteValue(index, TxRecord::indexKey(oldTx));
     }
-  } else {
-    tx.invalid = ((now + 300) > tx.unixDate);
+    batch.putValue(history, tx.hash, record);
+    batch.putValue(index, TxRecord::indexKey(tx), "");
+  }
+  return history.write(batch);
+}
+
+size_t Wallet::refreshTxStatuses(std::vector<TxData> txs) {
+  if (txs.empty()) { return 0; }
+  std::vector<Request> reqs;
+  reqs.push_back({1, "2.0", "eth_blockNumber", json::array()});
+  for (size_t i = 0; i < txs.size(); i++) {
+    reqs.push_back({i + 2, "2.0", "eth_getTransactionReceipt", {"0x" + txs[i].hex}});
+  }
+  std::map<uint64_t, json> answers;
+  try {
+    json resp = json::parse(API::httpGetRequest(API::buildMultiRequest(reqs)));
+    for (json &item : resp) {
+      if (item.contains("id") && item["id"].is_number_unsigned() && item.contains("result")) {
+        answers[item["id"].get<uint64_t>()] = item["result"];
+      }
+    }
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("Error refreshing tx statuses: ") + e.what());
+    return 0;
   }
+  if (!answers.count(1) || !answers[1].is_string()) { return 0; }
+  u256 currentBlock = boost::lexical_cast<HexTo<u256>>(answers[1].get<std::string>());
+  uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+    std::chrono::system_clock::now().time_since_epoch()
+  ).count();
+
+  std::vector<TxData> changed;
+  for (size_t i = 0; i < txs.size(); i++) {
+    auto answer = answers.find(i + 2);
+    if (answer == answers.end()) { continue; }  // Failed request, try again later
+    TxData &tx = txs[i];
+    bool confirmed = tx.confirmed;
+    bool invalid = tx.invalid;
+    json &receipt = answer->second;
+    if (receipt.is_object()) {
+      // Mined: reverted txs are invalid, the rest is confirmed once the node has the block
+      std::string status = receipt.value("status", "0x1");
+      u256 txBlock = boost::lexical_cast<HexTo<u256>>(receipt.value("blockNumber", "0x0"));
+      invalid = (status == "0x0");
+      confirmed = (!invalid && txBlock <= currentBlock);
+    } else {
+      // Not mined, consider it dropped after 5 minutes
+      invalid = (now > tx.unixDate + 300);
+    }
+    if (confirmed != tx.confirmed || invalid != tx.invalid) {
+      tx.confirmed = confirmed;
+      tx.invalid = invalid;
+      changed.push_back(tx);
+    }
+  }
+  if (!changed.empty() && !saveTxsToHistory(changed)) { return 0; }
+  return changed.size();
+}
+
+void Wallet::updateTxStatus(std::string txHash) {
+  TxData tx;
+  if (!getTxFromHistory(txHash, tx)) { return; }
+  refreshTxStatuses({tx});
+}
+
+size_t Wallet::refreshPendingTxStatuses() {
+  std::vector<TxData> pending;
+  this->db.historyTable().scan([&](const std::string &key, const std::string &value){
+    TxData tx;
+    if (TxRecord::decode(value, tx) && !tx.confirmed && !tx.invalid) { pending.push_back(tx); }
+    return true;
+  });
+  return refreshTxStatuses(pending);
+}
+
+void Wallet::updateTxStatus(std::string txHash, bool confirmed, bool invalid) {
+  TxData tx;
+  if (!getTxFromHistory(txHash, tx)) { return; }
+  tx.confirmed = confirmed;
+  tx.invalid = invalid;
   saveTxToHistory(tx);
 }
 
+void Wallet::trackTx(TxData tx) {
+  // Same window as updateTxStatus() gives a tx before calling it invalid
+  std::string txHash = tx.hash;
+  this->trackLock.lock();
+  uint64_t gen = this->trackGeneration;
+  this->trackLock.unlock();
+  TxTracker::track(tx.hex, [this, txHash, gen](TxTrackStatus status, json receipt){
+    if (status == TX_TIMEOUT) { return; }
+    this->trackLock.lock();
+    if (gen == this->trackGeneration) {
+      this->updateTxStatus(txHash, (status == TX_CONFIRMED), (status == TX_FAILED));
+    }
+    this->trackLock.unlock();
+  }, std::chrono::seconds(300), this);
+}
+
+void Wallet::cancelTrackedTxs() {
+  // Waits for any callback that's writing right now
+  this->trackLock.lock();
+  this->trackGeneration++;
+  this->trackLock.unlock();
+  TxTracker::cancel(this);
+}
+
 std::string Wallet::getConfigValue(std::string key) {
-  return this->db.getConfigDBValue(key);
+  return this->db.configTable().getValue(key);
 }
 
 bool Wallet::setConfigValue(std::string key, std::string value) {
-  return this->db.putConfigDBValue(key, value);
+  return this->db.configTable().putValue(key, value);
 }
 
 void Wallet::eraseAllHistory() {
-  this->db.deleteAllHistoryDBKeys();
+  this->db.historyTable().deleteAll(true);
 }
@@ -30,8 +30,15 @@
 #include <lib/ledger/ledger.h>
 
 #include <network/API.h>
+#include <network/PortfolioService.h>
+#include <network/PriceStore.h>
+#include <network/SwapRouter.h>
+#include <network/TxTracker.h>
 #include <core/BIP39.h>
 #include <core/Database.h>
+#include <core/KeySession.h>
+#include <core/NonceManager.h>
+#include <core/TxRecord.h>
 #include <core/Utils.h>
 
 using namespace dev;  // u256
@@ -61,6 +68,31 @@ class Wallet {
     std::time_t storedPassDeadline = 0;
     boost::thread storedPassThread;
 
+    // Decrypted secrets of Accounts unlocked for signing without the KDF.
+    KeySession keySession;
+
+    // Local nonces for sending batches of transactions.
+    NonceManager nonces;
+
+    // Generation of the tracked transactions' callbacks, bumped when the
+    // history they write to goes away (closing the wallet or switching
+    // Accounts). Callbacks hold the lock while writing, so the history
+    // is never closed under them.
+    uint64_t trackGeneration = 0;
+    std::mutex trackLock;
+
+    // Sign a transaction with an already decrypted secret.
+    // Returns the raw signed transaction in Hex, or an empty string on failure.
+    std::string signWithSecret(TransactionSkeleton txSkel, const Secret &s);
+
+    // Sign several transactions with the same secret, in parallel.
+    std::vector<std::string> signWithSecret(std::vector<TransactionSkeleton> txSkels, const Secret &s);
+
+    // Ask for the receipts of the given transactions (and the current block)
+    // in one batched request, and store any status changes in one write.
+    // Returns how many transactions changed.
+    size_t refreshTxStatuses(std::vector<TxData> txs);
+
     // List of registered ARC20 tokens.
     std::vector<ARC20Token> ARC20Tokens;
 
@@ -126,6 +158,9 @@ class Wallet {
 
     /**
      * (Re)Load and close the Wallet's databases.
+     * PriceStore is detached from the token database while it's reopened,
+     * and closing it also stops PortfolioService and SwapRouter, so nothing
+     * in the background is left with the old handle.
      */
     bool loadTokenDB();
     bool loadHistoryDB(std::string address);
@@ -157,6 +192,11 @@ class Wallet {
       int decimals, std::string avaxPairContract
     );
 
+    /**
+     * Register several ARC20 tokens into the Wallet in one atomic write.
+     */
+    bool addARC20Tokens(std::vector<ARC20Token> tokens);
+
     /**
      * Remove an ARC20 token from the Wallet.
      */
@@ -167,6 +207,24 @@ class Wallet {
      */
     bool ARC20TokenWasAdded(std::string address);
 
+    /**
+     * Get a token's metadata (name, symbol, decimals and AVAX pair) from
+     * the cache in the token database, by checksummed address.
+     * Addresses that aren't tokens are cached as well (isToken = false)
+     * for a day, so they're not asked for again right away.
+     * Returns false if the address isn't cached (or its entry expired).
+     */
+    bool getARC20TokenMeta(std::string address, ARC20Token &token, bool &isToken);
+
+    /**
+     * Cache the metadata for several tokens, and mark several addresses
+     * as not being tokens, in one atomic write.
+     */
+    bool saveARC20TokenMeta(std::vector<ARC20Token> tokens, std::vector<std::string> nonTokens);
+
+    // Get the table where daily token prices are stored (see PriceStore).
+    DBTable getPriceTable() { return this->db.tokenTable().subTable("prices"); }
+
     // ======================================================================
     // ACCOUNT MANAGEMENT
     // ======================================================================
@@ -187,6 +245,17 @@ class Wallet {
       std::string &seed, int64_t index, std::string name, std::string &pass
     );
 
+    /**
+     * Create/import several Accounts in the Wallet at once, based on a given
+     * seed and a starting index, one for each name (in order).
+     * Keys are derived from a single parent key and encrypted in parallel.
+     * Automatically reloads the Account list on success.
+     * Returns a list of address/name pairs, or an empty list on failure.
+     */
+    std::vector<std::pair<std::string, std::string>> createAccounts(
+      std::string &seed, int64_t start, std::vector<std::string> names, std::string &pass
+    );
+
     /**
      * Load all Ledger accounts stored in the Wallet.
      */
@@ -240,6 +309,16 @@ class Wallet {
      */
     Address userToAddress(std::string const& input);
 
+    /**
+     * Unlock an Account for signing for the given number of seconds and/or
+     * signatures (0 = no limit), so the keyfile's KDF runs only once.
+     * Returns true on success, false on failure (e.g. wrong password).
+     */
+    bool unlockAccount(std::string address, std::string pass, unsigned seconds, unsigned maxSignatures);
+
+    // Lock all unlocked Accounts, wiping their secrets from memory.
+    void lockAccounts();
+
     /**
      * Get the secret key for a given Account.
      * Returns the proper Secret, or an "empty" Secret on failure.
@@ -302,8 +381,10 @@ class Wallet {
 
     /**
      * Sign a transaction with user credentials.
+     * If the Account is unlocked, the password is checked against the
+     * session instead of decrypting the key file again.
      * Returns a string with the raw signed transaction in Hex,
-     * or an empty string on failure.
+     * or an empty string on failure (e.g. wrong password).
      */
     std::string signTransaction(TransactionSkeleton txSkel, std::string pass);
 
@@ -313,6 +394,23 @@ class Wallet {
      */
     json sendTransaction(std::string txidHex, std::string operation);
 
+    /**
+     * Sign and send several transactions from the same Account at once.
+     * Consecutive nonces are reserved locally from a single nonce query
+     * (the skeletons' nonces are ignored), the transactions are signed in
+     * parallel and broadcast as one JSON-RPC batch.
+     * Failed transactions that would leave a nonce gap are retried once and
+     * then replaced by 0-value transfers to self, so later ones don't get
+     * stuck; unused nonces at the end are given back when possible.
+     * All sent transactions are stored in history in one write.
+     * Returns the response (either "result" or "error") for each transaction,
+     * in order. Failed ones that were replaced have the replacement's hash
+     * in "cancelTx".
+     */
+    std::vector<json> sendTransactionBatch(
+      std::vector<TransactionSkeleton> txSkels, std::vector<std::string> operations, std::string pass
+    );
+
     // ======================================================================
     // HISTORY MANAGEMENT
     // ======================================================================
@@ -323,22 +421,72 @@ class Wallet {
     json txDataToJSON();
 
     /**
-     * (Re)Load the transaction history for the current Account.
+     * Convert the current Account's legacy tx records to the binary format
+     * and build the history index, if not done yet.
+     * Called when the history database is opened.
+     */
+    void upgradeTxHistory();
+
+    /**
+     * (Re)Load the whole transaction history for the current Account.
+     * Prefer loadTxHistoryPage() for showing the history.
      */
     void loadTxHistory();
 
     /**
-     * Save a new transaction to the history and reload the list.
+     * Load a page of the current Account's tx history, newest first.
+     * Pass an empty cursor for the first page, and the returned nextCursor
+     * for the following ones.
+     */
+    TxHistoryPage loadTxHistoryPage(
+      std::string cursor, size_t limit, TxHistoryFilter filter = TxHistoryFilter()
+    );
+
+    /**
+     * Get a single transaction from the current Account's history.
+     * Returns false if it's not there.
+     */
+    bool getTxFromHistory(std::string txHash, TxData &tx);
+
+    /**
+     * Save a transaction to the history (and its index).
      * Returns true on success, false on failure.
      */
     bool saveTxToHistory(TxData tx);
 
+    /**
+     * Same as above, but for several transactions in one atomic write.
+     */
+    bool saveTxsToHistory(std::vector<TxData> txs);
+
     /**
      * Update the confirmed status of a given transaction
      * made from the current Account in the API.
      */
     void updateTxStatus(std::string txHash);
 
+    /**
+     * Update the status of every pending (not confirmed nor invalid)
+     * transaction in the current Account's history at once.
+     * Returns how many transactions changed.
+     */
+    size_t refreshPendingTxStatuses();
+
+    /**
+     * Same as above, but with a status that's already known
+     * (e.g. from TxTracker), so no requests are made.
+     */
+    void updateTxStatus(std::string txHash, bool confirmed, bool invalid);
+
+    /**
+     * Track a sent transaction with TxTracker and update its status in
+     * the history once it's mined.
+     */
+    void trackTx(TxData tx);
+
+    // Stop updating the history for the transactions tracked so far.
+    void cancelTrackedTxs();
+
     /**
      * Erase all the entries from the tx history database.
      */
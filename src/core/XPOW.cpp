@@ -0,0 +1,237 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "XPOW.h"
+
+// Round constants and rotation/permutation tables for keccak-f[1600].
+static const uint64_t keccakRC[24] = {
+  0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+  0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+  0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+  0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+  0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+  0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+  0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+  0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+static const unsigned keccakRotc[24] = {
+  1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44
+};
+static const unsigned keccakPiln[24] = {
+  10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1
+};
+
+static inline uint64_t rotl64(uint64_t x, unsigned n) {
+  return (x << n) | (x >> (64 - n));
+}
+
+static inline uint64_t bswap64(uint64_t x) {
+  return __builtin_bswap64(x);
+}
+
+// Load 8 bytes as a little-endian lane.
+static inline uint64_t loadLane(const unsigned char* p) {
+  uint64_t ret = 0;
+  for (int i = 7; i >= 0; i--) { ret = (ret << 8) | p[i]; }
+  return ret;
+}
+
+// All loops over the lanes are innermost, so each step works on N states at once.
+template <size_t N> void XPOW::keccakf(uint64_t st[25][N]) {
+  uint64_t bc[5][N], t[N], tmp[N];
+  for (int round = 0; round < 24; round++) {
+    // Theta
+    for (int i = 0; i < 5; i++) {
+      for (size_t l = 0; l < N; l++) {
+        bc[i][l] = st[i][l] ^ st[i + 5][l] ^ st[i + 10][l] ^ st[i + 15][l] ^ st[i + 20][l];
+      }
+    }
+    for (int i = 0; i < 5; i++) {
+      for (size_t l = 0; l < N; l++) {
+        t[l] = bc[(i + 4) % 5][l] ^ rotl64(bc[(i + 1) % 5][l], 1);
+      }
+      for (int j = 0; j < 25; j += 5) {
+        for (size_t l = 0; l < N; l++) { st[j + i][l] ^= t[l]; }
+      }
+    }
+
+    // Rho and Pi
+    for (size_t l = 0; l < N; l++) { t[l] = st[1][l]; }
+    for (int i = 0; i < 24; i++) {
+      unsigned j = keccakPiln[i];
+      for (size_t l = 0; l < N; l++) {
+        tmp[l] = st[j][l];
+        st[j][l] = rotl64(t[l], keccakRotc[i]);
+        t[l] = tmp[l];
+      }
+    }
+
+    // Chi
+    for (int j = 0; j < 25; j += 5) {
+      for (int i = 0; i < 5; i++) {
+        for (size_t l = 0; l < N; l++) { bc[i][l] = st[j + i][l]; }
+      }
+      for (int i = 0; i < 5; i++) {
+        for (size_t l = 0; l < N; l++) {
+          st[j + i][l] ^= (~bc[(i + 1) % 5][l]) & bc[(i + 2) % 5][l];
+        }
+      }
+    }
+
+    // Iota
+    for (size_t l = 0; l < N; l++) { st[0][l] ^= keccakRC[round]; }
+  }
+}
+
+template <size_t N> void XPOW::hashLanes(const uint64_t nonces[4][N], uint64_t out[4][N]) const {
+  uint64_t st[25][N];
+  for (int i = 0; i < 25; i++) {
+    for (size_t l = 0; l < N; l++) { st[i][l] = (i < 17) ? this->blocks[0][i] : 0; }
+  }
+  // The nonce is stored big-endian at bytes 32-63, lanes are little-endian
+  for (int w = 0; w < 4; w++) {
+    for (size_t l = 0; l < N; l++) { st[4 + w][l] = bswap64(nonces[w][l]); }
+  }
+  keccakf<N>(st);
+  for (int i = 0; i < 17; i++) {
+    for (size_t l = 0; l < N; l++) { st[i][l] ^= this->blocks[1][i]; }
+  }
+  keccakf<N>(st);
+  for (int w = 0; w < 4; w++) {
+    for (size_t l = 0; l < N; l++) { out[w][l] = st[w][l]; }
+  }
+}
+
+unsigned XPOW::countWork(uint64_t l0, uint64_t l1, uint64_t l2, uint64_t l3) {
+  // The hash's first bytes are the lowest bytes of the first lane
+  uint64_t words[4] = {bswap64(l0), bswap64(l1), bswap64(l2), bswap64(l3)};
+  unsigned ret = 0;
+  for (int i = 0; i < 4; i++) {
+    if (words[i] != 0) { return ret + (__builtin_clzll(words[i]) / 4); }
+    ret += 16;
+  }
+  return ret;
+}
+
+XPOW::XPOW(const FixedHash<224> &job, unsigned threads) : job(job), stopped(false) {
+  this->threads = (threads > 0) ? threads : std::thread::hardware_concurrency();
+  if (this->threads == 0) { this->threads = 1; }
+  this->threadHashes.reset(new std::atomic<uint64_t>[this->threads]);
+  for (unsigned i = 0; i < this->threads; i++) { this->threadHashes[i] = 0; }
+
+  // Pad the job into two rate blocks (keccak padding: 0x01 ... 0x80)
+  unsigned char buf[272] = {0};
+  for (size_t i = 0; i < 224; i++) { buf[i] = job[i]; }
+  buf[224] = 0x01;
+  buf[271] |= 0x80;
+  for (int b = 0; b < 2; b++) {
+    for (int i = 0; i < 17; i++) { this->blocks[b][i] = loadLane(buf + (b * 136) + (i * 8)); }
+  }
+  this->searchStart = this->searchEnd = std::chrono::steady_clock::now();
+}
+
+h256 XPOW::hash(u256 nonce) const {
+  uint64_t nonces[4][1], out[4][1];
+  for (int w = 0; w < 4; w++) {
+    nonces[3 - w][0] = static_cast<uint64_t>(nonce >> (64 * w));
+  }
+  hashLanes<1>(nonces, out);
+  h256 ret;
+  for (int w = 0; w < 4; w++) {
+    for (int b = 0; b < 8; b++) { ret[(w * 8) + b] = (out[w][0] >> (b * 8)) & 0xFF; }
+  }
+  return ret;
+}
+
+void XPOW::worker(
+  unsigned id, u256 startNonce, unsigned minWork,
+  std::chrono::steady_clock::time_point deadline, std::atomic<uint64_t> &nextChunk,
+  std::vector<XPOWResult> &results, std::mutex &resultsMutex
+) {
+  uint64_t nonces[4][lanes], out[4][lanes];
+  std::vector<XPOWResult> found;
+  while (!this->stopped && std::chrono::steady_clock::now() < deadline) {
+    u256 cur = startNonce + u256(nextChunk++) * chunkSize;
+    uint64_t remaining = chunkSize;
+    while (remaining > 0) {
+      // Split the chunk where the lowest word of the nonce wraps around
+      uint64_t words[4];
+      for (int w = 0; w < 4; w++) { words[3 - w] = static_cast<uint64_t>(cur >> (64 * w)); }
+      uint64_t count = remaining;
+      if (words[3] != 0 && count - 1 > UINT64_MAX - words[3]) { count = (UINT64_MAX - words[3]) + 1; }
+
+      for (uint64_t i = 0; i < count; i += lanes) {
+        // The last group may be partial, extra lanes repeat the last nonce
+        for (size_t l = 0; l < lanes; l++) {
+          uint64_t offset = std::min<uint64_t>(i + l, count - 1);
+          nonces[0][l] = words[0];
+          nonces[1][l] = words[1];
+          nonces[2][l] = words[2];
+          nonces[3][l] = words[3] + offset;
+        }
+        hashLanes<lanes>(nonces, out);
+        for (size_t l = 0; l < lanes && i + l < count; l++) {
+          unsigned work = countWork(out[0][l], out[1][l], out[2][l], out[3][l]);
+          if (work >= minWork) { found.push_back({cur + (i + l), work}); }
+        }
+      }
+      cur += count;
+      remaining -= count;
+    }
+    this->threadHashes[id] += chunkSize;
+  }
+  resultsMutex.lock();
+  results.insert(results.end(), found.begin(), found.end());
+  resultsMutex.unlock();
+}
+
+std::vector<XPOWResult> XPOW::search(u256 startNonce, unsigned minWork, std::chrono::milliseconds duration) {
+  std::vector<XPOWResult> results;
+  std::mutex resultsMutex;
+  std::atomic<uint64_t> nextChunk(0);
+  this->stopped = false;
+  for (unsigned i = 0; i < this->threads; i++) { this->threadHashes[i] = 0; }
+
+  // Make sure the engine agrees with the reference keccak before spending any time
+  FixedHash<224> check = this->job;
+  h256 nonceBytes(startNonce);
+  for (size_t i = 0; i < 32; i++) { check[32 + i] = nonceBytes[i]; }
+  if (this->hash(startNonce) != dev::sha3(check)) {
+    Utils::logToDebug("XPOW engine hash mismatch, search aborted");
+    return results;
+  }
+
+  this->timeMutex.lock();
+  this->searchStart = std::chrono::steady_clock::now();
+  this->searchEnd = this->searchStart;
+  this->timeMutex.unlock();
+  std::chrono::steady_clock::time_point deadline = this->searchStart + duration;
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < this->threads; i++) {
+    workers.emplace_back(&XPOW::worker, this, i, startNonce, minWork,
+      deadline, std::ref(nextChunk), std::ref(results), std::ref(resultsMutex)
+    );
+  }
+  for (std::thread &t : workers) { t.join(); }
+  this->timeMutex.lock();
+  this->searchEnd = std::chrono::steady_clock::now();
+  this->timeMutex.unlock();
+  return results;
+}
+
+XPOWStats XPOW::getStats() {
+  XPOWStats ret;
+  this->timeMutex.lock();
+  std::chrono::steady_clock::time_point end = (this->searchEnd > this->searchStart)
+    ? this->searchEnd : std::chrono::steady_clock::now();
+  ret.seconds = std::chrono::duration<double>(end - this->searchStart).count();
+  this->timeMutex.unlock();
+  ret.hashes = 0;
+  for (unsigned i = 0; i < this->threads; i++) {
+    uint64_t hashes = this->threadHashes[i];
+    ret.hashes += hashes;
+    ret.threadRates.push_back((ret.seconds > 0) ? hashes / ret.seconds : 0);
+  }
+  ret.hashRate = (ret.seconds > 0) ? ret.hashes / ret.seconds : 0;
+  return ret;
+}
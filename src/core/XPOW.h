@@ -0,0 +1,116 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef XPOW_H
+#define XPOW_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <core/Utils.h>
+
+#include <lib/devcore/FixedHash.h>
+#include <lib/devcore/SHA3.h>
+
+using namespace dev;  // u256
+
+// A nonce that reached the minimum work, and how much work it has
+// (number of leading zero nibbles in its hash).
+typedef struct XPOWResult {
+  u256 nonce;
+  unsigned work;
+} XPOWResult;
+
+// Hash counters for the last search.
+typedef struct XPOWStats {
+  uint64_t hashes;                  // Total hashes done by all threads
+  double seconds;                   // How long the search ran
+  double hashRate;                  // Aggregate hashes per second
+  std::vector<double> threadRates;  // Hashes per second of each thread
+} XPOWStats;
+
+/**
+ * Nonce search engine for XPOW jobs.
+ * The job is the ABI-encoded (string type, uint256 nonce, address sender,
+ * uint256 interval, bytes32 blockHash) without the function selector
+ * (224 bytes), hashed with keccak256.
+ * The nonce space is handed out to all threads in chunks, and each thread
+ * hashes several nonces at once with a multi-lane keccak-f[1600], written
+ * so the compiler can vectorize it across lanes.
+ * The nonce sits in the first 136-byte block of the sponge, so nothing can
+ * be absorbed ahead of time, but every other input lane is built only once.
+ */
+class XPOW {
+  private:
+    // Number of nonces hashed at once by each thread, and nonces per chunk.
+    static const size_t lanes = 4;
+    static const uint64_t chunkSize = 1 << 14;
+
+    // The job itself, used to check the engine against dev::sha3.
+    FixedHash<224> job;
+
+    // The job's two padded input blocks (136 bytes each), as 64-bit lanes.
+    // Lanes 4-7 of the first block are the nonce and are filled in per hash.
+    uint64_t blocks[2][17];
+
+    // Number of worker threads.
+    unsigned threads;
+
+    // Stop flag and hash counters (one per thread) for the current/last search.
+    std::atomic<bool> stopped;
+    std::unique_ptr<std::atomic<uint64_t>[]> threadHashes;
+    std::chrono::steady_clock::time_point searchStart;
+    std::chrono::steady_clock::time_point searchEnd;
+    std::mutex timeMutex;
+
+    // Apply keccak-f[1600] to N independent states.
+    template <size_t N> static void keccakf(uint64_t state[25][N]);
+
+    /**
+     * Hash the job with N different nonces.
+     * Nonces are given as their 4 big-endian 64-bit words, the result is
+     * the first 4 lanes of the final state (i.e. the 32-byte hash).
+     */
+    template <size_t N> void hashLanes(const uint64_t nonces[4][N], uint64_t out[4][N]) const;
+
+    // Count the leading zero nibbles of a hash given as its 4 lanes.
+    static unsigned countWork(uint64_t l0, uint64_t l1, uint64_t l2, uint64_t l3);
+
+    // Worker loop for a single thread.
+    void worker(
+      unsigned id, u256 startNonce, unsigned minWork,
+      std::chrono::steady_clock::time_point deadline, std::atomic<uint64_t> &nextChunk,
+      std::vector<XPOWResult> &results, std::mutex &resultsMutex
+    );
+
+  public:
+    // Constructor. Uses every core if threads is 0.
+    XPOW(const FixedHash<224> &job, unsigned threads = 0);
+
+    /**
+     * Search for nonces with at least minWork leading zero nibbles,
+     * starting at startNonce, until the time is up or stop() is called.
+     * Blocks until the search is over, returns the nonces found (in no
+     * particular order).
+     */
+    std::vector<XPOWResult> search(u256 startNonce, unsigned minWork, std::chrono::milliseconds duration);
+
+    // Stop a running search. Can be called from any thread.
+    void stop() { this->stopped = true; }
+
+    // Get the hash counters and rates for the current/last search.
+    XPOWStats getStats();
+
+    // Hash the job with a single nonce.
+    h256 hash(u256 nonce) const;
+
+    // Get the number of worker threads.
+    unsigned getThreads() { return this->threads; }
+};
+
+#endif  // XPOW_H
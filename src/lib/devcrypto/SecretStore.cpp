@@ -4,8 +4,16 @@
 
 
 #include "SecretStore.h"
+#include <atomic>
+#include <exception>
 #include <thread>
 #include <mutex>
+#include <fcntl.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <lib/devcore/Guards.h>
@@ -20,6 +28,78 @@ namespace fs = boost::filesystem;
 
 static const int c_keyFileVersion = 3;
 
+/// Max threads used for encrypting keys (each scrypt run needs ~256MB) and for writing them.
+static const unsigned c_encryptThreads = 4;
+static const unsigned c_writeThreads = 8;
+
+/// Runs @a _f(i) for every i in [0, _count) on up to @a _maxThreads threads.
+/// The first exception thrown by @a _f is rethrown once all threads are done.
+static void parallelFor(size_t _count, unsigned _maxThreads, function<void(size_t)> const& _f)
+{
+	unsigned threads = max(1u, min(_maxThreads, thread::hardware_concurrency()));
+	if (_count < threads)
+		threads = unsigned(_count);
+	atomic<size_t> next(0);
+	exception_ptr error;
+	mutex errorMutex;
+	vector<thread> workers;
+	for (unsigned t = 0; t < threads; ++t)
+		workers.emplace_back([&]() {
+			for (size_t i = next++; i < _count; i = next++)
+			{
+				try
+				{
+					_f(i);
+				}
+				catch (...)
+				{
+					lock_guard<mutex> l(errorMutex);
+					if (!error)
+						error = current_exception();
+				}
+			}
+		});
+	for (auto& w: workers)
+		w.join();
+	if (error)
+		rethrow_exception(error);
+}
+
+/// Flushes a file or directory to disk. Directories can't be opened for syncing on
+/// Windows (NTFS journals renames anyway), so only files are synced there.
+static void syncPath(fs::path const& _path, bool _isDirectory)
+{
+#if defined(_WIN32)
+	if (_isDirectory)
+		return;
+	int fd = _wopen(_path.wstring().c_str(), _O_RDWR | _O_BINARY);
+	if (fd >= 0)
+	{
+		_commit(fd);
+		_close(fd);
+	}
+#else
+	(void)_isDirectory;
+	int fd = ::open(_path.string().c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		::fsync(fd);
+		::close(fd);
+	}
+#endif
+}
+
+/// Writes @a _content to @a _file through a synced temp file and a rename, so the
+/// file is never left half-written.
+static void writeFileAtomic(fs::path const& _file, string const& _content)
+{
+	fs::path tempPath = _file;
+	tempPath += ".tmp";
+	writeFile(tempPath, bytesConstRef(_content));
+	syncPath(tempPath, false);
+	fs::rename(tempPath, _file);
+}
+
 /// Upgrade the json-format to the current version.
 static js::mValue upgraded(string const& _s)
 {
@@ -131,9 +211,10 @@ bytesSec SecretStore::secret(string const& _content, string const& _pass)
 h128 SecretStore::importSecret(bytesSec const& _s, string const& _pass)
 {
 	h128 r = h128::random();
-	EncryptedKey key{encrypt(_s.ref(), _pass), toUUID(r), KeyPair(Secret(_s)).address()};
+	EncryptedKey key{encrypt(_s.ref(), _pass), fs::path(), KeyPair(Secret(_s)).address()};
 	m_cached[r] = _s;
 	m_keys[r] = move(key);
+	m_dirty.insert(r);
 	save();
 	return r;
 }
@@ -141,16 +222,38 @@ h128 SecretStore::importSecret(bytesSec const& _s, string const& _pass)
 h128 SecretStore::importSecret(bytesConstRef _s, string const& _pass)
 {
 	h128 r = h128::random();
-	EncryptedKey key{encrypt(_s, _pass), toUUID(r), KeyPair(Secret(_s)).address()};
+	EncryptedKey key{encrypt(_s, _pass), fs::path(), KeyPair(Secret(_s)).address()};
 	m_cached[r] = bytesSec(_s);
 	m_keys[r] = move(key);
+	m_dirty.insert(r);
 	save();
 	return r;
 }
 
+vector<h128> SecretStore::importSecrets(vector<bytesSec> const& _s, string const& _pass)
+{
+	vector<h128> ret(_s.size());
+	vector<EncryptedKey> keys(_s.size());
+	for (auto& r: ret)
+		r = h128::random();
+	// Encryption is by far the slowest part, so it's done in parallel before touching m_keys.
+	parallelFor(_s.size(), c_encryptThreads, [&](size_t i) {
+		keys[i] = EncryptedKey{encrypt(_s[i].ref(), _pass), fs::path(), KeyPair(Secret(_s[i])).address()};
+	});
+	for (size_t i = 0; i < _s.size(); ++i)
+	{
+		m_cached[ret[i]] = _s[i];
+		m_keys[ret[i]] = move(keys[i]);
+		m_dirty.insert(ret[i]);
+	}
+	save();
+	return ret;
+}
+
 void SecretStore::kill(h128 const& _uuid)
 {
 	m_cached.erase(_uuid);
+	m_dirty.erase(_uuid);
 	if (m_keys.count(_uuid))
 	{
 		fs::remove(m_keys[_uuid].filename);
@@ -163,26 +266,52 @@ void SecretStore::clearCache() const
 	m_cached.clear();
 }
 
+void SecretStore::writeKey(pair<h128 const, EncryptedKey>& _k, fs::path const& _keysPath)
+{
+	string uuid = toUUID(_k.first);
+	fs::path filename = (_keysPath / uuid).string() + ".json";
+	js::mObject v;
+	js::mValue crypto;
+	js::read_string(_k.second.encryptedKey, crypto);
+	v["address"] = _k.second.address.hex();
+	v["crypto"] = crypto;
+	v["id"] = uuid;
+	v["version"] = c_keyFileVersion;
+	writeFileAtomic(filename, js::write_string(js::mValue(v), true));
+	swap(_k.second.filename, filename);
+	if (!filename.empty() && fs::exists(filename) && !fs::equivalent(filename, _k.second.filename))
+		fs::remove(filename);
+}
+
 void SecretStore::save(fs::path const& _keysPath)
 {
 	fs::create_directories(_keysPath);
 	DEV_IGNORE_EXCEPTIONS(fs::permissions(_keysPath, fs::owner_all));
+	vector<pair<h128 const, EncryptedKey>*> toWrite;
 	for (auto& k: m_keys)
+		toWrite.push_back(&k);
+	parallelFor(toWrite.size(), c_writeThreads, [&](size_t i) { writeKey(*toWrite[i], _keysPath); });
+	syncPath(_keysPath, true);
+	if (_keysPath == m_path)
+		m_dirty.clear();
+}
+
+void SecretStore::save()
+{
+	if (m_dirty.empty())
+		return;
+	fs::create_directories(m_path);
+	DEV_IGNORE_EXCEPTIONS(fs::permissions(m_path, fs::owner_all));
+	vector<pair<h128 const, EncryptedKey>*> toWrite;
+	for (auto const& uuid: m_dirty)
 	{
-		string uuid = toUUID(k.first);
-		fs::path filename = (_keysPath / uuid).string() + ".json";
-		js::mObject v;
-		js::mValue crypto;
-		js::read_string(k.second.encryptedKey, crypto);
-		v["address"] = k.second.address.hex();
-		v["crypto"] = crypto;
-		v["id"] = uuid;
-		v["version"] = c_keyFileVersion;
-		writeFile(filename, js::write_string(js::mValue(v), true));
-		swap(k.second.filename, filename);
-		if (!filename.empty() && !fs::equivalent(filename, k.second.filename))
-			fs::remove(filename);
+		auto it = m_keys.find(uuid);
+		if (it != m_keys.end())
+			toWrite.push_back(&*it);
 	}
+	parallelFor(toWrite.size(), c_writeThreads, [&](size_t i) { writeKey(*toWrite[i], m_path); });
+	syncPath(m_path, true);
+	m_dirty.clear();
 }
 
 bool SecretStore::noteAddress(h128 const& _uuid, Address const& _address)
@@ -191,6 +320,7 @@ bool SecretStore::noteAddress(h128 const& _uuid, Address const& _address)
     if (it != m_keys.end() && it->second.address == ZeroAddress)
     {
         it->second.address = _address;
+        m_dirty.insert(_uuid);
         return true;
     }
     return false;
@@ -228,6 +358,9 @@ h128 SecretStore::readKeyContent(string const& _content, fs::path const& _file)
 			// else
 				// cwarn << "Account address is either not defined or not in hex format" << _file.string();
 			m_keys[uuid] = EncryptedKey{js::write_string(o["crypto"], false), _file, address};
+			// Keys that aren't already in their canonical file have to be (re)written
+			if (_file.empty() || _file.filename().string() != toUUID(uuid) + ".json")
+				m_dirty.insert(uuid);
 			return uuid;
 		}
 		// else
@@ -250,6 +383,7 @@ bool SecretStore::recode(Address const& _address, string const& _newPass, functi
 		else
 		{
 			k->second.encryptedKey = encrypt(s.ref(), _newPass, _kdf);
+			m_dirty.insert(k->first);
 			save();
 			return true;
 		}
@@ -280,6 +414,7 @@ bool SecretStore::recode(h128 const& _uuid, string const& _newPass, function<str
 		return false;
 	m_cached.erase(_uuid);
 	m_keys[_uuid].encryptedKey = encrypt(s.ref(), _newPass, _kdf);
+	m_dirty.insert(_uuid);
 	save();
 	return true;
 }
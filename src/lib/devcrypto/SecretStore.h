@@ -6,6 +6,7 @@
 
 #include <functional>
 #include <mutex>
+#include <unordered_set>
 #include <lib/devcore/FixedHash.h>
 #include <lib/devcore/FileSystem.h>
 #include <lib/devcore/CommonIO.h>
@@ -73,6 +74,10 @@ public:
 	/// (a key derived from) the password @a _pass.
 	h128 importSecret(bytesSec const& _s, std::string const& _pass);
 	h128 importSecret(bytesConstRef _s, std::string const& _pass);
+	/// Imports several decrypted keys at once, all encrypted with the password @a _pass.
+	/// Keys are encrypted and written in parallel, and the directory is synced once.
+	/// @returns the uuids of the imported keys, in the same order.
+	std::vector<h128> importSecrets(std::vector<bytesSec> const& _s, std::string const& _pass);
 	/// Decrypts and re-encrypts the key identified by @a _uuid.
 	bool recode(h128 const& _uuid, std::string const& _newPass, std::function<std::string()> const& _pass, KDF _kdf = KDF::Scrypt);
 	/// Decrypts and re-encrypts the key identified by @a _address.
@@ -102,8 +107,8 @@ public:
 
 	/// Store all keys in the directory @a _keysPath.
 	void save(boost::filesystem::path const& _keysPath);
-	/// Store all keys in the managed directory.
-	void save() { save(m_path); }
+	/// Store new or changed keys in the managed directory.
+	void save();
 	/// @returns true if the current file @arg _uuid contains an empty address. m_keys will be updated with the given @arg _address.
 	bool noteAddress(h128 const& _uuid, Address const& _address);
 	/// @returns the address of the given key or the zero address if it is unknown.
@@ -113,6 +118,8 @@ public:
 	static boost::filesystem::path defaultPath() { return getDataDir("web3") / boost::filesystem::path("keys"); }
 
 private:
+	/// Writes the file for a single key in the directory @a _keysPath, atomically (temp file + rename).
+	void writeKey(std::pair<h128 const, EncryptedKey>& _k, boost::filesystem::path const& _keysPath);
 	/// Loads all keys in the given directory.
 	void load(boost::filesystem::path const& _keysPath);
 	void load() { load(m_path); }
@@ -127,6 +134,8 @@ private:
 	mutable std::unordered_map<h128, bytesSec> m_cached;
 	/// Stores encrypted keys together with the file they were loaded from by uuid.
 	std::unordered_map<h128, EncryptedKey> m_keys;
+	/// Keys that were added or changed since they were last written to the managed directory.
+	std::unordered_set<h128> m_dirty;
 
 	boost::filesystem::path m_path;
 };
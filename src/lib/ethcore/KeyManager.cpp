@@ -187,6 +187,26 @@ h128 KeyManager::import(Secret const& _s, string const& _accountName, string con
 	return uuid;
 }
 
+vector<h128> KeyManager::import(vector<pair<Secret, string>> const& _keys, string const& _pass, string const& _passwordHint)
+{
+	auto passHash = hashPassword(_pass);
+	cachePassword(_pass);
+	m_passwordHint[passHash] = _passwordHint;
+	vector<bytesSec> secrets;
+	for (auto const& k: _keys)
+		secrets.push_back(k.first.asBytesSec());
+	auto uuids = m_store.importSecrets(secrets, _pass);
+	for (size_t i = 0; i < _keys.size(); ++i)
+	{
+		Address addr = KeyPair(_keys[i].first).address();
+		m_keyInfo[addr] = KeyInfo{passHash, _keys[i].second, ""};
+		m_addrLookup[addr] = uuids[i];
+		m_uuidLookup[uuids[i]] = addr;
+	}
+	write(m_keysFile);
+	return uuids;
+}
+
 void KeyManager::importExisting(h128 const& _uuid, string const& _info, string const& _pass, string const& _passwordHint)
 {
 	bytesSec key = m_store.secret(_uuid, [&](){ return _pass; });
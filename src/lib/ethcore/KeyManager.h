@@ -97,6 +97,11 @@ public:
 
 	h128 import(Secret const& _s, std::string const& _accountName, std::string const& _pass, std::string const& _passwordHint);
 	h128 import(Secret const& _s, std::string const& _accountName) { return import(_s, _accountName, defaultPassword(), std::string()); }
+	/// Imports several keys at once, all with the same password. The keys are encrypted in
+	/// parallel and the info file is written only once.
+	/// @param _keys pairs of secret and account name.
+	/// @returns the uuids of the imported keys, in the same order.
+	std::vector<h128> import(std::vector<std::pair<Secret, std::string>> const& _keys, std::string const& _pass, std::string const& _passwordHint);
 
 	SecretStore& store() { return m_store; }
 	void importExisting(h128 const& _uuid, std::string const& _accountName, std::string const& _pass, std::string const& _passwordHint);
@@ -4,6 +4,7 @@
 #include "main-gui.h"
 #include<iostream>
 #include<chrono>
+#include<algorithm>
 
 std::string getnNonceHex(u256 nNonce) {
 	std::string nNonceHex = "00000000000000000000000000000000";
@@ -25,20 +26,6 @@ std::string getnNonceHex(u256 nNonce) {
 	return nNonceHex;
 }
 
-void increaseNonce(FixedHash<224> &job){
-  int position = 63;
-  while (true) {
-    if (job[position] == 255) {
-      // Move to the next position and set the current position to 0
-      job[position] = 0;
-      --position;
-      continue;
-    }
-    ++job[position];
-    break;
-  }
-  return;
-}
 // Implementation of AVME Wallet as a GUI (Qt) program.
 int main(int argc, char *argv[]) {
   // Setup boost::filesystem environment and Qt's <APPNAME> for QStandardPaths
@@ -61,7 +48,6 @@ int main(int argc, char *argv[]) {
   std::string xpowType = argv[1];
   std::string blockhash = argv[2];
   u256 nNonce = boost::lexical_cast<u256>(argv[3]);
-  u256 startNonce = nNonce;
   std::string address = argv[4];
   u256 period = boost::lexical_cast<u256>(argv[5]);
   int min_work = boost::lexical_cast<int>(argv[6]);
@@ -104,30 +90,19 @@ int main(int argc, char *argv[]) {
   std::string jobStr = ABI::encodeABIfromJson(jobJson.dump());
   jobStr.erase(0,10); // Erase the first 10 characters, they are ignored.
   FixedHash<224> job(dev::fromHex(jobStr));
-  for (auto start = std::chrono::steady_clock::now(), now = start; now < start + std::chrono::seconds{seconds}; now = std::chrono::steady_clock::now()) 
-  {
-      u256 counter = 0;
-      auto hash = dev::sha3(job);
-      for (unsigned char c : hash) {
-        if (c == 0) {
-          counter += 2;
-          continue;
-        } else {
-          if (c < 16) {
-	        	++counter;    
-	        }
-          break;
-        }
-      }
-      if (counter >= min_work) {
-        bestNonce.push_back(std::pair<u256,u256>(nNonce, counter));
-        std::cout << "Good nonce: " << nNonce << " counter: " << counter << std::endl;
-      }
-      increaseNonce(job);
-      ++nNonce;
+  XPOW engine(job);
+  std::cout << "Threads: " << engine.getThreads() << std::endl;
+  std::vector<XPOWResult> results = engine.search(nNonce, min_work, std::chrono::seconds(seconds));
+  XPOWStats stats = engine.getStats();
+  for (XPOWResult result : results) {
+    bestNonce.push_back(std::pair<u256,u256>(result.nonce, result.work));
   }
+  std::sort(bestNonce.begin(), bestNonce.end());
 
-  std::cout << "Hash/s: " << ((nNonce - startNonce) / seconds) << std::endl;
+  std::cout << "Hash/s: " << uint64_t(stats.hashRate) << " (" << stats.hashes << " hashes)" << std::endl;
+  for (size_t i = 0; i < stats.threadRates.size(); i++) {
+    std::cout << "Thread " << i << " Hash/s: " << uint64_t(stats.threadRates[i]) << std::endl;
+  }
   for (auto _u256 : bestNonce) {
     std::cout << "Nonce: " << _u256.first << " counter: " << _u256.second << std::endl;
   }
@@ -143,16 +118,17 @@ int main(int argc, char *argv[]) {
   #endif
 
   // Create the actual application, register our custom classes into it and
-  // initialize the global thread pool to 128 threads.
-  // We should never reach this limit, but a high thread count should
-  // avoid taking too long to answer towards the websocket server.
+  // initialize the global thread pool. The websocket server has its own
+  // workers, so the pool only needs to cover the screens' background tasks.
   QApplication app(argc, argv);
   QQmlApplicationEngine engine;
   QmlSystem qmlsystem;
   qmlsystem.setEngine(&engine);
   engine.rootContext()->setContextProperty("qmlSystem", &qmlsystem);
   qmlRegisterType<QmlApi>("QmlApi", 1, 0, "QmlApi");
-  QThreadPool::globalInstance()->setMaxThreadCount(128);
+  QThreadPool::globalInstance()->setMaxThreadCount(
+    std::max(QThread::idealThreadCount() * 2, 16)
+  );
 
   // Set the app's text font and icon
   QFontDatabase::addApplicationFont(":/fonts/IBMPlexMono-Bold.ttf");
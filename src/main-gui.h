@@ -50,6 +50,7 @@ Q_IMPORT_PLUGIN(QtChartsQml2Plugin)
 #include <core/BIP39.h>
 #include <core/Utils.h>
 #include <core/Wallet.h>
+#include <core/XPOW.h>
 #include <network/Graph.h>
 #include <network/Pangolin.h>
 #include <network/Staking.h>
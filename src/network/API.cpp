@@ -2,11 +2,10 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file LICENSE or http://www.opensource.org/licenses/mit-license.php.
 #include "API.h"
+#include "RPCBatcher.h"
 
 std::string API::httpGetRequest(std::string reqBody, bool isWebSocket) {
   std::string result = "";
-  using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
-  namespace ssl = boost::asio::ssl;       // from <boost/asio/ssl.hpp>
   namespace http = boost::beast::http;    // from <boost/beast/http.hpp>
 
   std::string RequestID = Utils::randomHexBytes();
@@ -30,26 +29,7 @@ std::string API::httpGetRequest(std::string reqBody, bool isWebSocket) {
   apiMutex.unlock();
 
   try {
-    // Create context and load certificates into it
-    boost::asio::io_context ioc;
-    ssl::context ctx{ssl::context::sslv23_client};
-    load_root_certificates(ctx);
-
-    tcp::resolver resolver{ioc};
-    ssl::stream<tcp::socket> stream{ioc, ctx};
-
-    // Set SNI Hostname (many hosts need this to handshake successfully)
-    if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-      boost::system::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
-      throw boost::system::system_error{ec};
-    }
-    auto const results = resolver.resolve(host, port);
-
-    // Connect and Handshake
-    boost::asio::connect(stream.next_layer(), results.begin(), results.end());
-    stream.handshake(ssl::stream_base::client);
-
-    // Set up an HTTP GET request message
+    // Set up an HTTP POST request message
     http::request<http::string_body> req{http::verb::post, target, 11};
     req.set(http::field::host, host);
     req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
@@ -57,31 +37,10 @@ std::string API::httpGetRequest(std::string reqBody, bool isWebSocket) {
     req.body() = reqBody;
     req.prepare_payload();
 
-    // Send the HTTP request to the remote host
-    http::write(stream, req);
-    boost::beast::flat_buffer buffer;
-
-    // Declare a container to hold the response
-    http::response<http::dynamic_body> res;
-
-    // Receive the HTTP response
-    http::read(stream, buffer, res);
-
-    // Write only the body answer to output
-    std::string body { boost::asio::buffers_begin(res.body().data()),boost::asio::buffers_end(res.body().data()) };
-    result = body;
+    // Send it through a pooled keep-alive connection and get the answer
+    result = ConnectionPool::request(host, port, req);
     //Utils::logToDebug("API Result ID " + RequestID + " : " + result);
     //std::cout << "REQUEST RESULT: \n" << result << std::endl; // Uncomment for debugging
-
-    boost::system::error_code ec;
-    stream.shutdown(ec);
-
-    // SSL Connections return stream_truncated when closed.
-    // For that reason, we need to treat this as an error.
-    if (ec == boost::asio::error::eof || boost::asio::ssl::error::stream_truncated)
-      ec.assign(0, ec.category());
-    if (ec)
-      throw boost::system::system_error{ec};
   } catch (std::exception const& e) {
     //std::cout << "Error: " << e.what() << std::endl;
     Utils::logToDebug("API ID " + RequestID + " ERROR:" + e.what());
@@ -91,6 +50,35 @@ std::string API::httpGetRequest(std::string reqBody, bool isWebSocket) {
   return result;
 }
 
+void API::httpGetRequestAsync(std::string reqBody, ResponseHandler handler, bool isWebSocket) {
+  std::string host;
+  std::string port;
+  std::string target;
+
+  apiMutex.lock();
+  if (isWebSocket) {
+    host = webSocketHost;
+    port = webSocketPort;
+    target = webSocketTarget;
+  } else {
+    host = apiHost;
+    port = apiPort;
+    target = apiTarget;
+  }
+  apiMutex.unlock();
+
+  AsyncClient::request(host, port, target, reqBody, handler);
+}
+
+std::future<std::string> API::httpGetRequestFuture(std::string reqBody, bool isWebSocket) {
+  auto promise = std::make_shared<std::promise<std::string>>();
+  std::future<std::string> ret = promise->get_future();
+  httpGetRequestAsync(reqBody, [promise](std::string resp){
+    promise->set_value(resp);
+  }, isWebSocket);
+  return ret;
+}
+
 void API::httpGetFile(std::string host, std::string get, std::string target) {
   using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
   namespace ssl = boost::asio::ssl;       // from <boost/asio/ssl.hpp>
@@ -99,19 +87,13 @@ void API::httpGetFile(std::string host, std::string get, std::string target) {
   boost::system::error_code error;
 
   try {
-    // Create context and load certificates into it
+    // Use the shared context, certificates are already loaded into it
     boost::asio::io_context ioc;
-    ssl::context ctx{ssl::context::sslv23_client};
-    load_root_certificates(ctx);
-
     tcp::resolver resolver{ioc};
-    ssl::stream<tcp::socket> stream{ioc, ctx};
+    ssl::stream<tcp::socket> stream{ioc, TLSContext::get()};
 
     // Set SNI Hostname (many hosts need this to handshake successfully)
-    if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-      boost::system::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
-      throw boost::system::system_error{ec};
-    }
+    TLSContext::prepare(stream.native_handle(), host);
     auto const results = resolver.resolve(host, "443"); // Always HTTPS
 
     // Connect and Handshake
@@ -165,19 +147,13 @@ std::string API::customHttpRequest(std::string reqBody, std::string host, std::s
   //Utils::logToDebug("API Request ID " + RequestID + " : " + reqBody);
 
   try {
-    // Create context and load certificates into it
+    // Use the shared context, certificates are already loaded into it
     boost::asio::io_context ioc;
-    ssl::context ctx{ssl::context::sslv23_client};
-    load_root_certificates(ctx);
-
     tcp::resolver resolver{ioc};
-    ssl::stream<tcp::socket> stream{ioc, ctx};
+    ssl::stream<tcp::socket> stream{ioc, TLSContext::get()};
 
     // Set SNI Hostname (many hosts need this to handshake successfully)
-    if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-      boost::system::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
-      throw boost::system::system_error{ec};
-    }
+    TLSContext::prepare(stream.native_handle(), host);
     auto const results = resolver.resolve(host, port);
 
     // Connect and Handshake
@@ -264,42 +240,76 @@ std::string API::buildMultiRequest(std::vector<Request> reqs) {
 
 std::string API::broadcastTx(std::string txidHex) {
   Request req{1, "2.0", "eth_sendRawTransaction", {"0x" + txidHex}};
-  std::string query = buildRequest(req);
-  std::string resp = httpGetRequest(query);
-  return resp;
+  json respJson = RPCBatcher::call(req);
+  return respJson.dump();
+}
+
+std::vector<json> API::broadcastTxs(std::vector<std::string> txidHexes) {
+  std::vector<json> ret(txidHexes.size());
+  std::vector<Request> reqs;
+  for (size_t i = 0; i < txidHexes.size(); i++) {
+    reqs.push_back({i + 1, "2.0", "eth_sendRawTransaction", {"0x" + txidHexes[i]}});
+  }
+  // Transactions are never deduped or cached, so they're sent as is
+  json resp;
+  try {
+    resp = json::parse(API::httpGetRequest(API::buildMultiRequest(reqs)));
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("Error broadcasting transactions: ") + e.what());
+  }
+  if (resp.is_array()) {
+    for (json &answer : resp) {
+      if (!answer.contains("id") || !answer["id"].is_number_unsigned()) { continue; }
+      uint64_t id = answer["id"].get<uint64_t>();
+      if (id >= 1 && id <= ret.size()) { ret[id - 1] = answer; }
+    }
+  }
+  for (json &answer : ret) {
+    if (!answer.contains("result") && !answer.contains("error")) {
+      answer["jsonrpc"] = "2.0";
+      answer["error"]["code"] = -32603;
+      answer["error"]["message"] = "Internal error";
+    }
+  }
+  return ret;
 }
 
 std::string API::getNonce(std::string address) {
   Request req{1, "2.0", "eth_getTransactionCount", {address, "latest"}};
-  std::string query = buildRequest(req);
-  std::string resp = httpGetRequest(query);
-  json respJson = json::parse(resp);
+  json respJson = RPCBatcher::call(req);
   return respJson["result"].get<std::string>();
 }
 
+bool API::getPendingNonce(std::string address, uint64_t &nonce) {
+  Request req{1, "2.0", "eth_getTransactionCount", {address, "pending"}};
+  json respJson = RPCBatcher::call(req);
+  if (!respJson.contains("result") || !respJson["result"].is_string()) { return false; }
+  try {
+    nonce = boost::lexical_cast<HexTo<uint64_t>>(respJson["result"].get<std::string>());
+  } catch (std::exception &e) {
+    return false;
+  }
+  return true;
+}
+
 std::string API::getCurrentBlock() {
-  Request req{1, "2.0", "eth_blockNumber", {}};
-  std::string query = buildRequest(req);
-  std::string resp = httpGetRequest(query);
-  json respJson = json::parse(resp);
+  Request req{1, "2.0", "eth_blockNumber", json::array()};
+  json respJson = RPCBatcher::call(req);
   return respJson["result"].get<std::string>();
 }
 
 std::string API::getTxStatus(std::string txidHex) {
   Request req{1, "2.0", "eth_getTransactionReceipt", {"0x" + txidHex}};
-  std::string query = buildRequest(req);
-  //std::cout << query << std::endl;
-  std::string resp = httpGetRequest(query);
-  //std::cout << resp << std::endl;
-  json respJson = json::parse(resp);
+  //std::cout << req.params.dump() << std::endl;
+  json respJson = RPCBatcher::call(req);
+  //std::cout << respJson.dump() << std::endl;
   return respJson["result"].dump();
 }
 
 std::string API::getTxBlock(std::string txidHex) {
   Request req{1, "2.0", "eth_getTransactionReceipt", {"0x" + txidHex}};
-  std::string query = buildRequest(req);
-  std::string resp = httpGetRequest(query);
-  return resp;
+  json respJson = RPCBatcher::call(req);
+  return respJson.dump();
 }
 
 void API::setDefaultAPI(std::string desiredHost, std::string desiredPort, std::string desiredTarget) {
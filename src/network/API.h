@@ -15,8 +15,10 @@
 #include <boost/beast/version.hpp>
 
 #include <core/Utils.h>
+#include <network/AsyncClient.h>
+#include <network/ConnectionPool.h>
 #include <network/Pangolin.h>
-#include <network/root_certificates.hpp>
+#include <network/TLSContext.h>
 #include <lib/nlohmann_json/json.hpp>
 
 // For convenience.
@@ -50,6 +52,14 @@ namespace API {
      */
     std::string httpGetRequest(std::string reqBody, bool isWebSocket = false);
 
+    /**
+     * Same as above, but asynchronous: returns immediately and calls the
+     * handler (from a network thread) with the JSON data, or an empty string
+     * at connection failure. The future version returns that same string.
+     */
+    void httpGetRequestAsync(std::string reqBody, ResponseHandler handler, bool isWebSocket = false);
+    std::future<std::string> httpGetRequestFuture(std::string reqBody, bool isWebSocket = false);
+
     /**
      * Sends a HTTP GET/POST request to host/port/target filled by the caller
      * this function serves as a easy-to-access method for developers building their own applications inside the wallet
@@ -77,12 +87,25 @@ namespace API {
      */
     std::string broadcastTx(std::string txidHex);
 
+    /**
+     * Broadcast several signed transactions as one JSON-RPC batch.
+     * Returns the response object (with either a "result" or an "error")
+     * for each transaction, in the same order.
+     */
+    std::vector<json> broadcastTxs(std::vector<std::string> txidHexes);
+
     /**
      * Get the highest available nonce for an address from the blockchain API.
      * Returns the nonce, or an empty string on failure.
      */
     std::string getNonce(std::string address);
 
+    /**
+     * Same as above, but including the transactions still in the mempool.
+     * Returns the nonce as a number, or false on failure.
+     */
+    bool getPendingNonce(std::string address, uint64_t &nonce);
+
     /**
      * Get the current block number in the blockchain.
      * Returns the number.
@@ -0,0 +1,179 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "AsyncClient.h"
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+using tcp = boost::asio::ip::tcp;
+
+unsigned short AsyncClient::threads = 4;
+unsigned short AsyncClient::timeout = 30;
+
+void AsyncRequest::run() {
+  net::dispatch(strand_, beast::bind_front_handler(
+    &AsyncRequest::on_run, shared_from_this()
+  ));
+}
+
+void AsyncRequest::on_run() {
+  this->start_ = std::chrono::steady_clock::now();
+  timer_.expires_after(AsyncClient::getTimeout());
+  timer_.async_wait(net::bind_executor(strand_, beast::bind_front_handler(
+    &AsyncRequest::on_timeout, shared_from_this()
+  )));
+  this->reused_ = ConnectionPool::acquire(host_ + ":" + port_, conn_);
+  if (this->reused_) { do_write(); } else { do_connect(); }
+}
+
+void AsyncRequest::do_connect() {
+  conn_.stream.reset(new ConnectionPool::Stream{AsyncClient::getContext(), TLSContext::get()});
+  try {
+    TLSContext::prepare(conn_.stream->native_handle(), host_);
+  } catch (boost::system::system_error const& e) {
+    return fail(e.code(), "sni");
+  }
+  resolver_.async_resolve(host_, port_, net::bind_executor(strand_, beast::bind_front_handler(
+    &AsyncRequest::on_resolve, shared_from_this()
+  )));
+}
+
+void AsyncRequest::on_resolve(beast::error_code ec, tcp::resolver::results_type results) {
+  if (ec) { return fail(ec, "resolve"); }
+  net::async_connect(conn_.stream->next_layer(), results, net::bind_executor(strand_, beast::bind_front_handler(
+    &AsyncRequest::on_connect, shared_from_this()
+  )));
+}
+
+void AsyncRequest::on_connect(beast::error_code ec, tcp::endpoint endpoint) {
+  boost::ignore_unused(endpoint);
+  if (ec) { return fail(ec, "connect"); }
+  conn_.stream->async_handshake(ssl::stream_base::client, net::bind_executor(strand_, beast::bind_front_handler(
+    &AsyncRequest::on_handshake, shared_from_this()
+  )));
+}
+
+void AsyncRequest::on_handshake(beast::error_code ec) {
+  if (ec) { return fail(ec, "handshake"); }
+  do_write();
+}
+
+void AsyncRequest::do_write() {
+  if (this->done_) { return; }
+  http::async_write(*conn_.stream, req_, net::bind_executor(strand_, beast::bind_front_handler(
+    &AsyncRequest::on_write, shared_from_this()
+  )));
+}
+
+void AsyncRequest::on_write(beast::error_code ec, std::size_t bytes_transferred) {
+  boost::ignore_unused(bytes_transferred);
+  if (ec) { return fail(ec, "write"); }
+  http::async_read(*conn_.stream, buffer_, res_, net::bind_executor(strand_, beast::bind_front_handler(
+    &AsyncRequest::on_read, shared_from_this()
+  )));
+}
+
+void AsyncRequest::on_read(beast::error_code ec, std::size_t bytes_transferred) {
+  if (ec) {
+    this->answered_ = (bytes_transferred > 0 || buffer_.size() > 0);
+    return fail(ec, "read");
+  }
+  finish(res_.body(), res_.keep_alive());
+}
+
+void AsyncRequest::on_timeout(beast::error_code ec) {
+  if (ec == net::error::operation_aborted || this->done_) { return; }
+  // Cancel whatever is pending, the handler of that operation gets the
+  // error, but the request is already answered here so it won't retry
+  Utils::logToDebug("Async request to " + host_ + " timed out");
+  resolver_.cancel();
+  finish("", false);
+}
+
+void AsyncRequest::fail(beast::error_code ec, char const* what) {
+  if (this->done_) { return; }
+  if (this->reused_ && !this->answered_ && ConnectionPool::isRetryable(req_)) {
+    // The server dropped the connection while it was idle (usually EOF
+    // or stream_truncated) and never answered. Retry once on a fresh one.
+    ConnectionPool::close(conn_);
+    ConnectionPool::reconnects++;
+    this->reused_ = false;
+    res_ = {};
+    buffer_.consume(buffer_.size());
+    return do_connect();
+  }
+  Utils::logToDebug(std::string("Async request ") + what + " ERROR: " + ec.message());
+  finish("", false);
+}
+
+void AsyncRequest::finish(std::string body, bool keepAlive) {
+  this->done_ = true;
+  timer_.cancel();
+  if (conn_.stream != nullptr) {
+    ConnectionPool::record(this->reused_, std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - this->start_
+    ).count());
+    if (keepAlive) {
+      ConnectionPool::release(host_ + ":" + port_, std::move(conn_));
+    } else {
+      // Only close the socket, an operation might still be pending on the
+      // stream, which is freed along with the request
+      boost::system::error_code ignored;
+      conn_.stream->next_layer().close(ignored);
+    }
+  }
+  ResponseHandler handler = std::move(handler_);
+  handler_ = nullptr;
+  try {
+    handler(body);
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("Async request handler ERROR: ") + e.what());
+  }
+}
+
+boost::asio::io_context& AsyncClient::getContext() {
+  // Intentionally never destroyed: pooled connections and detached workers
+  // may still reference it while other static objects are being destroyed
+  static net::io_context* ioc = [](){
+    net::io_context* ctx = new net::io_context();
+    auto work = new net::executor_work_guard<net::io_context::executor_type>(ctx->get_executor());
+    boost::ignore_unused(work);
+    for (unsigned short i = 0; i < AsyncClient::threads; i++) {
+      std::thread([ctx]{ ctx->run(); }).detach();
+    }
+    return ctx;
+  }();
+  return *ioc;
+}
+
+std::chrono::seconds AsyncClient::getTimeout() {
+  return std::chrono::seconds(AsyncClient::timeout);
+}
+
+void AsyncClient::request(
+  std::string host, std::string port, std::string target,
+  std::string reqBody, ResponseHandler handler, std::string contentType
+) {
+  http::request<http::string_body> req{http::verb::post, target, 11};
+  req.set(http::field::host, host);
+  req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+  req.set(http::field::content_type, contentType);
+  req.keep_alive(true);
+  req.body() = reqBody;
+  req.prepare_payload();
+  std::make_shared<AsyncRequest>(getContext(), host, port, std::move(req), handler)->run();
+}
+
+std::future<std::string> AsyncClient::requestFuture(
+  std::string host, std::string port, std::string target,
+  std::string reqBody, std::string contentType
+) {
+  auto promise = std::make_shared<std::promise<std::string>>();
+  std::future<std::string> ret = promise->get_future();
+  request(host, port, target, reqBody, [promise](std::string resp){
+    promise->set_value(resp);
+  }, contentType);
+  return ret;
+}
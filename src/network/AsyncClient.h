@@ -0,0 +1,131 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef ASYNCCLIENT_H
+#define ASYNCCLIENT_H
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+
+#include <core/Utils.h>
+#include <network/ConnectionPool.h>
+#include <network/TLSContext.h>
+
+// Callback for async requests. Receives the response body, or an empty
+// string at connection failure (same as the blocking API functions).
+typedef std::function<void(std::string)> ResponseHandler;
+
+/**
+ * A single asynchronous HTTPS request, adapted from the Beast async client example:
+ * https://www.boost.org/doc/libs/1_76_0/libs/beast/example/http/client/async-ssl/http_client_async_ssl.cpp
+ * Takes a connection from ConnectionPool when there's one idle, otherwise
+ * resolves, connects and handshakes without blocking any thread.
+ * All handlers run on the request's own strand.
+ */
+class AsyncRequest : public std::enable_shared_from_this<AsyncRequest> {
+  std::string host_;
+  std::string port_;
+  boost::beast::http::request<boost::beast::http::string_body> req_;
+  boost::beast::http::response<boost::beast::http::string_body> res_;
+  boost::beast::flat_buffer buffer_;
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  boost::asio::ip::tcp::resolver resolver_;
+  boost::asio::steady_timer timer_;
+  ConnectionPool::Connection conn_;
+  ResponseHandler handler_;
+  std::chrono::steady_clock::time_point start_;
+  bool reused_ = false;
+  bool done_ = false;
+  bool answered_ = false;  // Part of the response was read, the server got the request
+
+  public:
+    AsyncRequest(
+      boost::asio::io_context& ioc, std::string host, std::string port,
+      boost::beast::http::request<boost::beast::http::string_body> req,
+      ResponseHandler handler
+    ) : host_(host), port_(port), req_(std::move(req)), strand_(ioc.get_executor()),
+      resolver_(ioc), timer_(ioc), handler_(handler) {}
+
+    // Start the asynchronous operation.
+    void run();
+
+  private:
+    // Start the request in the strand and arm the timeout.
+    void on_run();
+
+    // Open a new connection (resolve, connect and handshake).
+    void do_connect();
+    void on_resolve(boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type results);
+    void on_connect(boost::beast::error_code ec, boost::asio::ip::tcp::endpoint endpoint);
+    void on_handshake(boost::beast::error_code ec);
+
+    // Send the request and read the response.
+    void do_write();
+    void on_write(boost::beast::error_code ec, std::size_t bytes_transferred);
+    void on_read(boost::beast::error_code ec, std::size_t bytes_transferred);
+
+    // Drop the connection if the server takes too long to answer.
+    void on_timeout(boost::beast::error_code ec);
+
+    /**
+     * Handle a network error. A reused connection that failed before the
+     * timeout and before any of the response was read (e.g. closed by the
+     * server while idle) is replaced once, if the request is retryable
+     * (see ConnectionPool::isRetryable()). Otherwise the handler gets an
+     * empty string.
+     */
+    void fail(boost::beast::error_code ec, char const* what);
+
+    // Give the connection back (if possible) and call the handler once.
+    void finish(std::string body, bool keepAlive);
+};
+
+/**
+ * Shared asynchronous HTTP client. Owns the process-wide io_context (also
+ * used by ConnectionPool) and a small fixed pool of threads running it.
+ * Requests in flight don't hold a thread while waiting on the network.
+ */
+class AsyncClient {
+  private:
+    // Number of threads running the io_context, and seconds before a request times out.
+    static unsigned short threads;
+    static unsigned short timeout;
+
+  public:
+    // Get the shared io_context. Worker threads are started on the first call.
+    static boost::asio::io_context& getContext();
+
+    // Get the request timeout.
+    static std::chrono::seconds getTimeout();
+
+    /**
+     * Send an HTTP POST request to the given endpoint without blocking.
+     * handler is called from one of the worker threads with the response body,
+     * or an empty string at connection failure.
+     */
+    static void request(
+      std::string host, std::string port, std::string target,
+      std::string reqBody, ResponseHandler handler,
+      std::string contentType = "application/json"
+    );
+
+    // Same as above, but returns a future with the response body instead.
+    static std::future<std::string> requestFuture(
+      std::string host, std::string port, std::string target,
+      std::string reqBody, std::string contentType = "application/json"
+    );
+};
+
+#endif  // ASYNCCLIENT_H
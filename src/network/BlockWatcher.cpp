@@ -0,0 +1,110 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "BlockWatcher.h"
+
+std::map<uint64_t, BlockHandler> BlockWatcher::handlers;
+uint64_t BlockWatcher::nextId = 1;
+std::unique_ptr<boost::asio::steady_timer> BlockWatcher::timer;
+std::chrono::milliseconds BlockWatcher::interval = std::chrono::milliseconds(1000);
+bool BlockWatcher::polling = false;
+std::atomic<uint64_t> BlockWatcher::lastBlock(0);
+std::mutex BlockWatcher::watchMutex;
+
+void BlockWatcher::poll() {
+  // Always asked directly, so the answer never comes from the cache
+  Request req{1, "2.0", "eth_blockNumber", json::array()};
+  API::httpGetRequestAsync(API::buildRequest(req), [](std::string resp){
+    uint64_t block = 0;
+    try {
+      json respJson = json::parse(resp);
+      block = boost::lexical_cast<HexTo<uint64_t>>(respJson["result"].get<std::string>());
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("BlockWatcher ERROR: ") + e.what());
+    }
+
+    std::vector<BlockHandler> toCall;
+    if (block > lastBlock) {
+      lastBlock = block;
+      RPCCache::onBlock(block);
+      watchMutex.lock();
+      for (std::pair<const uint64_t, BlockHandler> &h : handlers) { toCall.push_back(h.second); }
+      watchMutex.unlock();
+    }
+    for (BlockHandler &handler : toCall) {
+      try {
+        handler(block);
+      } catch (std::exception &e) {
+        Utils::logToDebug(std::string("BlockWatcher handler ERROR: ") + e.what());
+      }
+    }
+    schedule();
+  });
+}
+
+void BlockWatcher::schedule() {
+  watchMutex.lock();
+  if (handlers.empty()) {
+    polling = false;
+    watchMutex.unlock();
+    return;
+  }
+  if (timer == nullptr) {
+    timer.reset(new boost::asio::steady_timer(AsyncClient::getContext()));
+  }
+  timer->expires_after(interval);
+  timer->async_wait([](boost::system::error_code ec){
+    if (ec != boost::asio::error::operation_aborted) { poll(); }
+  });
+  watchMutex.unlock();
+}
+
+uint64_t BlockWatcher::subscribe(BlockHandler handler) {
+  watchMutex.lock();
+  uint64_t id = nextId++;
+  handlers[id] = handler;
+  bool start = !polling;
+  polling = true;
+  watchMutex.unlock();
+  if (start) { poll(); }
+  return id;
+}
+
+void BlockWatcher::unsubscribe(uint64_t id) {
+  // Polling stops by itself on the next round if no one is left
+  watchMutex.lock();
+  handlers.erase(id);
+  watchMutex.unlock();
+}
+
+void BlockWatcher::setInterval(uint64_t milliseconds) {
+  watchMutex.lock();
+  interval = std::chrono::milliseconds((milliseconds > 0) ? milliseconds : 1);
+  watchMutex.unlock();
+}
+
+bool BlockSubscription::start() {
+  this->subMutex.lock();
+  bool ret = (this->id == 0);
+  if (ret) { this->id = BlockWatcher::subscribe(this->handler); }
+  this->subMutex.unlock();
+  return ret;
+}
+
+bool BlockSubscription::stop() {
+  this->subMutex.lock();
+  bool ret = (this->id != 0);
+  if (ret) {
+    BlockWatcher::unsubscribe(this->id);
+    this->id = 0;
+  }
+  this->subMutex.unlock();
+  return ret;
+}
+
+bool BlockSubscription::isActive() {
+  this->subMutex.lock();
+  bool ret = (this->id != 0);
+  this->subMutex.unlock();
+  return ret;
+}
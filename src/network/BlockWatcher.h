@@ -0,0 +1,96 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef BLOCKWATCHER_H
+#define BLOCKWATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <boost/asio.hpp>
+
+#include <network/API.h>
+#include <network/AsyncClient.h>
+#include <network/RPCCache.h>
+
+// Callback for new blocks. Receives the new block number.
+typedef std::function<void(uint64_t)> BlockHandler;
+
+/**
+ * Shared watcher for new blocks on the chain.
+ * Polls eth_blockNumber on the shared io_context (no thread of its own),
+ * but only while someone is subscribed, and tells every subscriber once
+ * per new block. New blocks also invalidate RPCCache.
+ */
+class BlockWatcher {
+  private:
+    // Subscribers by id.
+    static std::map<uint64_t, BlockHandler> handlers;
+    static uint64_t nextId;
+
+    // Polling timer, interval, and whether a poll is scheduled or in flight.
+    static std::unique_ptr<boost::asio::steady_timer> timer;
+    static std::chrono::milliseconds interval;
+    static bool polling;
+
+    // Last block seen.
+    static std::atomic<uint64_t> lastBlock;
+
+    // Mutex for all the members above (except lastBlock).
+    static std::mutex watchMutex;
+
+    // Ask for the current block, then schedule the next poll if still needed.
+    static void poll();
+    static void schedule();
+
+  public:
+    /**
+     * Subscribe to new blocks. Handlers are called from a network thread,
+     * so they must not block on network calls.
+     * Returns an id for unsubscribing.
+     */
+    static uint64_t subscribe(BlockHandler handler);
+    static void unsubscribe(uint64_t id);
+
+    // Get the last block seen (0 if none yet).
+    static uint64_t getLastBlock() { return lastBlock; }
+
+    // Set the polling interval (in milliseconds).
+    static void setInterval(uint64_t milliseconds);
+};
+
+/**
+ * A BlockWatcher subscription that's turned on and off as needed, for
+ * services that only watch blocks while they're in use.
+ * BlockWatcher never calls a handler from inside subscribe(), so start()
+ * and stop() can be called while holding the owner's own lock, which keeps
+ * them in order with the owner's state (e.g. a stop() can't undo a later
+ * start() from another thread).
+ */
+class BlockSubscription {
+  private:
+    BlockHandler handler;
+    uint64_t id = 0;  // 0 if not subscribed
+    std::mutex subMutex;
+
+  public:
+    explicit BlockSubscription(BlockHandler handler) : handler(handler) {}
+    BlockSubscription(const BlockSubscription&) = delete;
+    BlockSubscription& operator=(const BlockSubscription&) = delete;
+
+    // Subscribe if not subscribed yet. Returns true if this call subscribed.
+    bool start();
+
+    // Unsubscribe if subscribed. Returns true if this call unsubscribed.
+    bool stop();
+
+    // Check if subscribed.
+    bool isActive();
+};
+
+#endif  // BLOCKWATCHER_H
@@ -0,0 +1,140 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "BridgeExecutor.h"
+
+BridgeExecutor::BridgeExecutor(unsigned workerCount, size_t capacity) : capacity(capacity) {
+  if (this->capacity < 2) { this->capacity = 2; }
+  if (workerCount == 0) { workerCount = 1; }
+  for (unsigned i = 0; i < workerCount; i++) {
+    this->workers.emplace_back(&BridgeExecutor::workerLoop, this);
+  }
+}
+
+BridgeExecutor::~BridgeExecutor() {
+  this->execMutex.lock();
+  this->stopped = true;
+  this->execMutex.unlock();
+  this->execCond.notify_all();
+  for (std::thread &w : this->workers) { w.join(); }
+}
+
+void BridgeExecutor::workerLoop() {
+  std::unique_lock<std::mutex> lock(this->execMutex);
+  while (true) {
+    this->execCond.wait(lock, [this]{ return this->stopped || !this->ready.empty(); });
+    if (this->stopped) { return; }
+    std::shared_ptr<Queue> queue = this->ready.front();
+    this->ready.pop_front();
+    if (queue->removed || queue->tasks.empty()) { queue->scheduled = false; continue; }
+    Task task = std::move(queue->tasks.front());
+    queue->tasks.pop_front();
+    lock.unlock();
+
+    // Run the task outside the lock
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string method;
+    try {
+      method = task.fn();
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("Bridge task ERROR: ") + e.what());
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double waitMs = std::chrono::duration<double, std::milli>(start - task.queued).count();
+    double runMs = std::chrono::duration<double, std::milli>(end - start).count();
+    task.fn = nullptr;  // Release anything held by the task before taking the lock again
+
+    lock.lock();
+    BridgeMethodStats &stats = this->methodStats[(method.empty()) ? "unknown" : method];
+    stats.calls++;
+    stats.totalWaitMs += waitMs;
+    stats.totalRunMs += runMs;
+    stats.maxWaitMs = std::max(stats.maxWaitMs, waitMs);
+    stats.maxRunMs = std::max(stats.maxRunMs, runMs);
+
+    // Resume reading once the queue is down to half
+    std::function<void()> resume;
+    if (queue->paused && !queue->removed && queue->tasks.size() <= this->capacity / 2) {
+      queue->paused = false;
+      resume = queue->resume;
+    }
+    // Back to the end of the line, so other sessions get their turn
+    if (!queue->removed && !queue->tasks.empty()) {
+      this->ready.push_back(queue);
+      this->execCond.notify_one();
+    } else {
+      queue->scheduled = false;
+    }
+    if (resume) {
+      lock.unlock();
+      try {
+        resume();
+      } catch (std::exception &e) {
+        Utils::logToDebug(std::string("Bridge resume ERROR: ") + e.what());
+      }
+      lock.lock();
+    }
+  }
+}
+
+void BridgeExecutor::addQueue(const void* owner, std::function<void()> resume) {
+  std::shared_ptr<Queue> queue = std::make_shared<Queue>();
+  queue->resume = resume;
+  this->execMutex.lock();
+  this->queues[owner] = queue;
+  this->execMutex.unlock();
+}
+
+void BridgeExecutor::removeQueue(const void* owner) {
+  // Tasks are destroyed outside the lock, as they may hold the last
+  // reference to their session
+  std::deque<Task> dropped;
+  std::function<void()> resume;
+  this->execMutex.lock();
+  auto it = this->queues.find(owner);
+  if (it != this->queues.end()) {
+    it->second->removed = true;
+    dropped.swap(it->second->tasks);
+    resume.swap(it->second->resume);
+    this->queues.erase(it);
+  }
+  this->execMutex.unlock();
+}
+
+bool BridgeExecutor::submit(const void* owner, BridgeTask fn) {
+  this->execMutex.lock();
+  auto it = this->queues.find(owner);
+  if (it == this->queues.end()) {
+    this->execMutex.unlock();
+    return true;  // Session is gone, nothing to pause
+  }
+  std::shared_ptr<Queue> queue = it->second;
+  queue->tasks.push_back({fn, std::chrono::steady_clock::now()});
+  this->maxDepth = std::max(this->maxDepth, queue->tasks.size());
+  if (!queue->scheduled) {
+    queue->scheduled = true;
+    this->ready.push_back(queue);
+    this->execCond.notify_one();
+  }
+  bool ret = (queue->tasks.size() < this->capacity);
+  if (!ret) {
+    queue->paused = true;
+    this->pauses++;
+  }
+  this->execMutex.unlock();
+  return ret;
+}
+
+BridgeStats BridgeExecutor::getStats() {
+  BridgeStats ret;
+  this->execMutex.lock();
+  ret.queued = 0;
+  for (std::pair<const void* const, std::shared_ptr<Queue>> &q : this->queues) {
+    ret.queued += q.second->tasks.size();
+  }
+  ret.maxDepth = this->maxDepth;
+  ret.pauses = this->pauses;
+  ret.methods = this->methodStats;
+  this->execMutex.unlock();
+  return ret;
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef BRIDGEEXECUTOR_H
+#define BRIDGEEXECUTOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <core/Utils.h>
+
+// A bridge task. Returns the JSON-RPC method it handled, for the metrics.
+typedef std::function<std::string()> BridgeTask;
+
+// Latency metrics for a JSON-RPC method, in milliseconds.
+typedef struct BridgeMethodStats {
+  uint64_t calls = 0;
+  double totalWaitMs = 0;  // Time spent in the queue
+  double totalRunMs = 0;   // Time spent running
+  double maxWaitMs = 0;
+  double maxRunMs = 0;
+} BridgeMethodStats;
+
+// Queue metrics for the whole executor.
+typedef struct BridgeStats {
+  size_t queued;          // Tasks waiting right now, in all queues
+  size_t maxDepth;        // Deepest any single queue has been
+  uint64_t pauses;        // How many times a queue got full and reading was paused
+  std::map<std::string, BridgeMethodStats> methods;
+} BridgeStats;
+
+/**
+ * Executor for requests coming from DApps through the WebSocket bridge.
+ * Every session gets its own bounded queue, and a fixed number of workers
+ * take tasks from the queues in turns, at most one task per queue at a time.
+ * This keeps each session's requests in order and stops a single busy
+ * session from holding more than one worker. Tasks must not block on the
+ * user: requests waiting for a dialog are parked by the handler and
+ * answered later, so a few workers are enough.
+ * When a queue is full the session is told to stop reading, and its resume
+ * callback is called once the queue drains down to half.
+ */
+class BridgeExecutor {
+  private:
+    // A task and when it was queued.
+    typedef struct Task {
+      BridgeTask fn;
+      std::chrono::steady_clock::time_point queued;
+    } Task;
+
+    // A session's queue. "scheduled" means it's either in the ready list
+    // or being run by a worker, so it's never picked by two workers.
+    typedef struct Queue {
+      std::deque<Task> tasks;
+      std::function<void()> resume;
+      bool scheduled = false;
+      bool paused = false;
+      bool removed = false;
+    } Queue;
+
+    // Queues by owner (session), and queues with tasks waiting for a worker.
+    std::map<const void*, std::shared_ptr<Queue>> queues;
+    std::deque<std::shared_ptr<Queue>> ready;
+
+    // Max tasks per queue before its session has to stop reading.
+    size_t capacity;
+
+    // Workers and their signals.
+    std::vector<std::thread> workers;
+    std::condition_variable execCond;
+    bool stopped = false;
+
+    // Metrics.
+    size_t maxDepth = 0;
+    uint64_t pauses = 0;
+    std::map<std::string, BridgeMethodStats> methodStats;
+
+    // Mutex for all the members above.
+    std::mutex execMutex;
+
+    // Run tasks until the executor is destroyed.
+    void workerLoop();
+
+  public:
+    BridgeExecutor(unsigned workerCount = 4, size_t capacity = 64);
+    ~BridgeExecutor();
+    BridgeExecutor(const BridgeExecutor&) = delete;
+    BridgeExecutor& operator=(const BridgeExecutor&) = delete;
+
+    /**
+     * Create a queue for a session. resume is called (from a worker)
+     * when a paused session can start reading again.
+     */
+    void addQueue(const void* owner, std::function<void()> resume);
+
+    // Remove a session's queue, dropping any tasks still waiting in it.
+    void removeQueue(const void* owner);
+
+    /**
+     * Queue a task for a session. The task is always accepted, but if the
+     * queue is now full, returns false and the session must stop reading
+     * until its resume callback is called.
+     */
+    bool submit(const void* owner, BridgeTask fn);
+
+    // Get the current metrics.
+    BridgeStats getStats();
+};
+
+#endif  // BRIDGEEXECUTOR_H
@@ -0,0 +1,199 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "ConnectionPool.h"
+#include "AsyncClient.h"
+
+std::map<std::string, std::deque<ConnectionPool::Connection>> ConnectionPool::idleConns;
+size_t ConnectionPool::maxIdle = 8;
+std::chrono::seconds ConnectionPool::idleTimeout = std::chrono::seconds(30);
+std::atomic<uint64_t> ConnectionPool::hits(0);
+std::atomic<uint64_t> ConnectionPool::misses(0);
+std::atomic<uint64_t> ConnectionPool::reconnects(0);
+std::atomic<uint64_t> ConnectionPool::hitTimeUs(0);
+std::atomic<uint64_t> ConnectionPool::missTimeUs(0);
+std::mutex ConnectionPool::poolMutex;
+
+bool ConnectionPool::acquire(std::string key, Connection &conn) {
+  std::vector<Connection> expired;
+  bool found = false;
+  auto now = std::chrono::steady_clock::now();
+  poolMutex.lock();
+  auto it = idleConns.find(key);
+  if (it != idleConns.end()) {
+    // Oldest connections are at the front, drop the ones that went stale
+    while (!it->second.empty() && now - it->second.front().lastUsed > idleTimeout) {
+      expired.push_back(std::move(it->second.front()));
+      it->second.pop_front();
+    }
+    if (!it->second.empty()) {
+      conn = std::move(it->second.back());
+      it->second.pop_back();
+      found = true;
+    }
+  }
+  poolMutex.unlock();
+  for (Connection &c : expired) { close(c); }
+  return found;
+}
+
+void ConnectionPool::release(std::string key, Connection conn) {
+  conn.lastUsed = std::chrono::steady_clock::now();
+  poolMutex.lock();
+  std::deque<Connection> &list = idleConns[key];
+  if (list.size() < maxIdle) {
+    list.push_back(std::move(conn));
+    poolMutex.unlock();
+    return;
+  }
+  poolMutex.unlock();
+  close(conn);
+}
+
+ConnectionPool::Connection ConnectionPool::connect(std::string host, std::string port) {
+  using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
+  namespace ssl = boost::asio::ssl;       // from <boost/asio/ssl.hpp>
+
+  Connection conn;
+  conn.stream.reset(new Stream{AsyncClient::getContext(), TLSContext::get()});
+  tcp::resolver resolver{AsyncClient::getContext()};
+
+  // Set SNI Hostname and offer the last session for resumption
+  TLSContext::prepare(conn.stream->native_handle(), host);
+  auto const results = resolver.resolve(host, port);
+
+  // Connect and Handshake
+  boost::asio::connect(conn.stream->next_layer(), results.begin(), results.end());
+  conn.stream->handshake(ssl::stream_base::client);
+  conn.lastUsed = std::chrono::steady_clock::now();
+  return conn;
+}
+
+void ConnectionPool::close(Connection &conn) {
+  if (conn.stream == nullptr) { return; }
+  // Skip the TLS shutdown, a dead peer would never answer it
+  boost::system::error_code ec;
+  conn.stream->next_layer().close(ec);
+  conn.stream.reset();
+}
+
+bool ConnectionPool::exchange(
+  Connection &conn,
+  boost::beast::http::request<boost::beast::http::string_body> &req,
+  boost::beast::http::response<boost::beast::http::string_body> &res,
+  bool &answered
+) {
+  namespace http = boost::beast::http;    // from <boost/beast/http.hpp>
+  answered = false;
+  http::write(*conn.stream, req);
+  boost::beast::flat_buffer buffer;
+  boost::system::error_code ec;
+  std::size_t bytesRead = http::read(*conn.stream, buffer, res, ec);
+  if (ec) {
+    answered = (bytesRead > 0 || buffer.size() > 0);
+    throw boost::system::system_error(ec);
+  }
+  return res.keep_alive();
+}
+
+bool ConnectionPool::isRetryable(
+  const boost::beast::http::request<boost::beast::http::string_body> &req
+) {
+  const std::string &body = req.body();
+  return (body.find("\"eth_sendRawTransaction\"") == std::string::npos &&
+    body.find("\"eth_sendTransaction\"") == std::string::npos);
+}
+
+std::string ConnectionPool::request(
+  std::string host, std::string port,
+  boost::beast::http::request<boost::beast::http::string_body> &req
+) {
+  namespace http = boost::beast::http;    // from <boost/beast/http.hpp>
+  std::string key = host + ":" + port;
+  auto start = std::chrono::steady_clock::now();
+  http::response<http::string_body> res;
+  Connection conn;
+  bool reused = acquire(key, conn);
+  bool keepAlive = false;
+  req.keep_alive(true);
+
+  bool answered = false;
+  if (reused) {
+    try {
+      keepAlive = exchange(conn, req, res, answered);
+    } catch (boost::system::system_error const& e) {
+      // The server dropped the connection while it was idle (usually EOF
+      // or stream_truncated). Retry once on a fresh one, but only if the
+      // server never answered and sending it again is harmless.
+      close(conn);
+      if (answered || !isRetryable(req)) { throw; }
+      res = {};
+      reused = false;
+      reconnects++;
+    }
+  }
+  if (!reused) {
+    conn = connect(host, port);
+    keepAlive = exchange(conn, req, res, answered);
+  }
+
+  record(reused, std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start
+  ).count());
+
+  // Only give the connection back if the server allows it
+  if (keepAlive) {
+    release(key, std::move(conn));
+  } else {
+    close(conn);
+  }
+  return res.body();
+}
+
+void ConnectionPool::record(bool reused, uint64_t elapsedUs) {
+  if (reused) {
+    hits++;
+    hitTimeUs += elapsedUs;
+  } else {
+    misses++;
+    missTimeUs += elapsedUs;
+  }
+}
+
+PoolStats ConnectionPool::getStats() {
+  PoolStats stats;
+  stats.hits = hits;
+  stats.misses = misses;
+  stats.reconnects = reconnects;
+  stats.avgHitMs = (stats.hits > 0) ? (hitTimeUs / 1000.0) / stats.hits : 0;
+  stats.avgMissMs = (stats.misses > 0) ? (missTimeUs / 1000.0) / stats.misses : 0;
+  stats.idle = 0;
+  poolMutex.lock();
+  for (auto &list : idleConns) { stats.idle += list.second.size(); }
+  stats.maxIdle = maxIdle;
+  stats.idleTimeout = idleTimeout.count();
+  poolMutex.unlock();
+  return stats;
+}
+
+void ConnectionPool::setMaxIdle(size_t size) {
+  poolMutex.lock();
+  maxIdle = size;
+  poolMutex.unlock();
+}
+
+void ConnectionPool::setIdleTimeout(uint64_t seconds) {
+  poolMutex.lock();
+  idleTimeout = std::chrono::seconds(seconds);
+  poolMutex.unlock();
+}
+
+void ConnectionPool::clear() {
+  std::map<std::string, std::deque<Connection>> conns;
+  poolMutex.lock();
+  conns.swap(idleConns);
+  poolMutex.unlock();
+  for (auto &list : conns) {
+    for (Connection &c : list.second) { close(c); }
+  }
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+
+#include <network/TLSContext.h>
+
+// Struct for the pool's counters, as returned by ConnectionPool::getStats().
+typedef struct PoolStats {
+  uint64_t hits;          // Requests served by an already open connection
+  uint64_t misses;        // Requests that had to open a new connection
+  uint64_t reconnects;    // Reused connections that were dead and got replaced
+  uint64_t idle;          // Connections currently waiting in the pool
+  uint64_t maxIdle;       // Max number of idle connections kept per endpoint
+  uint64_t idleTimeout;   // Seconds an idle connection is kept before being dropped
+  double avgHitMs;        // Average request time (ms) when reusing a connection
+  double avgMissMs;       // Average request time (ms) when opening a new connection
+} PoolStats;
+
+class AsyncRequest;
+
+/**
+ * Pool of persistent (HTTP/1.1 keep-alive) TLS connections, grouped by
+ * endpoint (host:port). A connection is taken out of the pool for exactly
+ * one request/response and given back afterwards, so DNS resolution and the
+ * TCP/TLS handshake are paid once per connection instead of once per request.
+ * Connections closed by the server while idle (EOF/stream_truncated) are
+ * replaced transparently.
+ */
+class ConnectionPool {
+  // Async requests take and give back connections from the pool as well.
+  friend class AsyncRequest;
+
+  public:
+    typedef boost::asio::ssl::stream<boost::asio::ip::tcp::socket> Stream;
+
+    // A single pooled connection and the last time it was used.
+    typedef struct Connection {
+      std::unique_ptr<Stream> stream;
+      std::chrono::steady_clock::time_point lastUsed;
+    } Connection;
+
+  private:
+    // Idle connections for each endpoint, most recently used at the back.
+    static std::map<std::string, std::deque<Connection>> idleConns;
+
+    // Pool limits. Changeable at runtime through the setters below.
+    static size_t maxIdle;
+    static std::chrono::seconds idleTimeout;
+
+    // Counters and accumulated request times (in microseconds).
+    static std::atomic<uint64_t> hits;
+    static std::atomic<uint64_t> misses;
+    static std::atomic<uint64_t> reconnects;
+    static std::atomic<uint64_t> hitTimeUs;
+    static std::atomic<uint64_t> missTimeUs;
+
+    // Mutex for the idle connection list and limits.
+    static std::mutex poolMutex;
+
+    /**
+     * Get an idle connection for the given endpoint, discarding any that
+     * went past the idle timeout. Returns false if there's none available.
+     */
+    static bool acquire(std::string key, Connection &conn);
+
+    /**
+     * Give a connection back to the pool after a successful request.
+     * Connections above the per-endpoint limit are closed instead.
+     */
+    static void release(std::string key, Connection conn);
+
+    // Open a new connection (resolve, connect and handshake) to the given endpoint.
+    static Connection connect(std::string host, std::string port);
+
+    // Close a connection, ignoring any errors (the peer might be gone already).
+    static void close(Connection &conn);
+
+    // Account a finished request in the counters.
+    static void record(bool reused, uint64_t elapsedUs);
+
+    /**
+     * Write a request and read the response through the given connection.
+     * Returns whether the server allows the connection to be kept alive.
+     * Throws on any network error, setting answered if any part of the
+     * response was read before it (the server got the request then).
+     */
+    static bool exchange(
+      Connection &conn,
+      boost::beast::http::request<boost::beast::http::string_body> &req,
+      boost::beast::http::response<boost::beast::http::string_body> &res,
+      bool &answered
+    );
+
+    /**
+     * Check if a request can be sent again on a fresh connection after a
+     * reused one failed. Requests that change state on the chain
+     * (eth_sendRawTransaction/eth_sendTransaction) are never sent twice.
+     */
+    static bool isRetryable(
+      const boost::beast::http::request<boost::beast::http::string_body> &req
+    );
+
+  public:
+    /**
+     * Send an HTTP request to the given endpoint, reusing a pooled connection
+     * when possible. If a reused connection turns out to be dead before any
+     * of the response was read, the request is retried once on a fresh one
+     * (unless it's not retryable, see isRetryable()).
+     * Returns the response body. Throws on network failure, callers are
+     * expected to catch it like with any other Beast request.
+     */
+    static std::string request(
+      std::string host, std::string port,
+      boost::beast::http::request<boost::beast::http::string_body> &req
+    );
+
+    // Get the pool's counters and current limits.
+    static PoolStats getStats();
+
+    // Set the max number of idle connections kept per endpoint and how long
+    // (in seconds) they can stay idle, respectively.
+    static void setMaxIdle(size_t size);
+    static void setIdleTimeout(uint64_t seconds);
+
+    // Close all idle connections (e.g. when switching APIs).
+    static void clear();
+};
+
+#endif  // CONNECTIONPOOL_H
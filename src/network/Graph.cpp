@@ -18,19 +18,13 @@ std::string Graph::httpGetRequest(std::string reqBody) {
   //Utils::logToDebug("GRAPH Request ID " + RequestID + " : " + reqBody);
 
   try {
-    // Create context and load certificates into it
+    // Use the shared context, certificates are already loaded into it
     boost::asio::io_context ioc;
-    ssl::context ctx{ssl::context::sslv23_client};
-    load_root_certificates(ctx);
-
     tcp::resolver resolver{ioc};
-    ssl::stream<tcp::socket> stream{ioc, ctx};
+    ssl::stream<tcp::socket> stream{ioc, TLSContext::get()};
 
     // Set SNI Hostname (many hosts need this to handshake successfully)
-    if (!SSL_set_tlsext_host_name(stream.native_handle(), Graph::host.c_str())) {
-      boost::system::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
-      throw boost::system::system_error{ec};
-    }
+    TLSContext::prepare(stream.native_handle(), Graph::host);
     auto const results = resolver.resolve(Graph::host, Graph::port);
 
     // Connect and Handshake
@@ -79,6 +73,10 @@ std::string Graph::httpGetRequest(std::string reqBody) {
   return result;
 }
 
+void Graph::httpGetRequestAsync(std::string reqBody, ResponseHandler handler) {
+  AsyncClient::request(Graph::host, Graph::port, Graph::target, reqBody, handler);
+}
+
 /**
  * Prices are inverted, taking the WAVAX-USDT pair as an example:
  * - If token0 is WAVAX, token1Price is 1 WAVAX price in USDT
@@ -150,9 +148,8 @@ json Graph::getTokenPriceHistory(std::string address, int days) {
   return arr;
 }
 
-json Graph::getAccountPrices(std::vector<ARC20Token> tokenList) {
+std::string Graph::accountPricesQuery(std::vector<ARC20Token> tokenList) {
   std::stringstream query;
-  json ret;
 
   // Get USD AVAX price with ID USDAVAX.
   query << "{\"query\": \"{"
@@ -175,8 +172,17 @@ json Graph::getAccountPrices(std::vector<ARC20Token> tokenList) {
 
   // Close the query
   query << "}\"}";
-  std::string resp = httpGetRequest(query.str());
+  return query.str();
+}
+
+json Graph::getAccountPrices(std::vector<ARC20Token> tokenList) {
+  json ret;
+  std::string resp = httpGetRequest(accountPricesQuery(tokenList));
   ret = json::parse(resp);
   return ret;
 }
 
+void Graph::getAccountPricesAsync(std::vector<ARC20Token> tokenList, ResponseHandler handler) {
+  AsyncClient::request(Graph::host, Graph::port, Graph::target, accountPricesQuery(tokenList), handler);
+}
+
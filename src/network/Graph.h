@@ -15,7 +15,8 @@
 #include <boost/beast/version.hpp>
 
 #include <core/Utils.h>
-#include <network/root_certificates.hpp>
+#include <network/AsyncClient.h>
+#include <network/TLSContext.h>
 
 /**
  * Class for Pangolin's Graph-related functions (e.g. market data, fiat balances, etc.).
@@ -28,6 +29,9 @@ class Graph {
     static std::string port;
     static std::string target;
 
+    // Build the GraphQL query used by getAccountPrices().
+    static std::string accountPricesQuery(std::vector<ARC20Token> tokenList);
+
   public:
     /**
      * Send an HTTP GET Request to the blockchain API.
@@ -36,6 +40,12 @@ class Graph {
      */
     static std::string httpGetRequest(std::string reqBody);
 
+    /**
+     * Same as above, but asynchronous: the handler is called (from a network
+     * thread) with the raw JSON data, or an empty string at connection failure.
+     */
+    static void httpGetRequestAsync(std::string reqBody, ResponseHandler handler);
+
     /**
      * Get the CURRENT price in fiat (USD) for 1 unit (fixed point) of AVAX
      * and a given token, respectively.
@@ -63,6 +73,12 @@ class Graph {
      * Get the account prices for both AVAX and Tokens
      */
     static json getAccountPrices(std::vector<ARC20Token> tokenList);
+
+    /**
+     * Same as above, but asynchronous: the handler is called (from a network
+     * thread) with the raw JSON data, or an empty string at connection failure.
+     */
+    static void getAccountPricesAsync(std::vector<ARC20Token> tokenList, ResponseHandler handler);
 };
 
 #endif // GRAPH_H
@@ -0,0 +1,162 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "Multicall.h"
+
+std::string Multicall::address = "0xcA11bde05977b3631167028862bE2a173976CA11";
+std::atomic<uint64_t> Multicall::maxChunkGas(20000000);
+std::atomic<uint64_t> Multicall::maxChunkBytes(32768);
+std::atomic<uint64_t> Multicall::defaultCallGas(50000);
+
+// aggregate3((address,bool,bytes)[])
+static const std::string aggregate3Func = "0x82ad56cb";
+
+// Encode a number as a 32-byte ABI word.
+static std::string toWord(uint64_t value) {
+  return ABI::encodeABI("uint*", {std::to_string(value)}, false);
+}
+
+// Read the 32-byte ABI word at the given position (in hex chars) as a number.
+static uint64_t readWord(const std::string &hex, size_t pos) {
+  if (pos + 64 > hex.size()) { throw std::runtime_error("Multicall: data too short"); }
+  std::vector<std::string> parsed = Pangolin::parseHex(hex.substr(pos, 64), {"uint"});
+  if (parsed.empty()) { throw std::runtime_error("Multicall: invalid word"); }
+  return boost::lexical_cast<uint64_t>(parsed[0]);
+}
+
+// Size in bytes of a call's calldata (without "0x").
+static uint64_t callDataBytes(const MulticallCall &call) {
+  size_t start = (call.callData.substr(0, 2) == "0x") ? 2 : 0;
+  return (call.callData.size() - start) / 2;
+}
+
+MulticallCall Multicall::makeCall(std::string target, std::string callData, bool allowFailure) {
+  MulticallCall call;
+  call.target = target;
+  call.callData = callData;
+  call.allowFailure = allowFailure;
+  call.gas = 0;
+  return call;
+}
+
+std::vector<size_t> Multicall::chunkSizes(const std::vector<MulticallCall> &calls) {
+  std::vector<size_t> sizes;
+  uint64_t chunkGas = maxChunkGas, chunkBytes = maxChunkBytes, callGasDefault = defaultCallGas;
+  size_t count = 0;
+  uint64_t gas = 0, bytes = 0;
+  for (const MulticallCall &call : calls) {
+    uint64_t callGas = (call.gas > 0) ? call.gas : callGasDefault;
+    // Each call takes 5 words (offset, address, bool, bytes offset and length) plus its padded data
+    uint64_t callBytes = 160 + ((callDataBytes(call) + 31) / 32) * 32;
+    if (count > 0 && (gas + callGas > chunkGas || bytes + callBytes > chunkBytes)) {
+      sizes.push_back(count);
+      count = 0;
+      gas = bytes = 0;
+    }
+    count++;
+    gas += callGas;
+    bytes += callBytes;
+  }
+  if (count > 0) { sizes.push_back(count); }
+  return sizes;
+}
+
+std::string Multicall::encodeAggregate3(const std::vector<MulticallCall> &calls) {
+  // Head: offset to the array, its length and the offset to each tuple
+  // (relative to the start of the offsets), then the tuples themselves
+  std::string heads, tuples;
+  uint64_t offset = 32 * calls.size();
+  for (const MulticallCall &call : calls) {
+    std::string data = (call.callData.substr(0, 2) == "0x") ? call.callData.substr(2) : call.callData;
+    uint64_t dataBytes = data.size() / 2;
+    while (data.size() % 64 != 0) { data += "0"; }
+    std::string tuple = ABI::encodeABI("address", {call.target}, false)
+      + ABI::encodeABI("bool", {(call.allowFailure) ? "1" : "0"}, false)
+      + toWord(96) + toWord(dataBytes) + data;
+    heads += toWord(offset);
+    offset += tuple.size() / 2;
+    tuples += tuple;
+  }
+  return aggregate3Func + toWord(32) + toWord(calls.size()) + heads + tuples;
+}
+
+std::vector<MulticallResult> Multicall::decodeAggregate3(std::string hex) {
+  std::vector<MulticallResult> ret;
+  if (hex.substr(0, 2) == "0x") { hex = hex.substr(2); }
+  size_t arrayPos = readWord(hex, 0) * 2;
+  uint64_t count = readWord(hex, arrayPos);
+  size_t headsPos = arrayPos + 64;
+  for (uint64_t i = 0; i < count; i++) {
+    size_t tuplePos = headsPos + readWord(hex, headsPos + (i * 64)) * 2;
+    MulticallResult result;
+    result.success = (readWord(hex, tuplePos) != 0);
+    result.answered = true;
+    size_t dataPos = tuplePos + readWord(hex, tuplePos + 64) * 2;
+    uint64_t dataLength = readWord(hex, dataPos) * 2;
+    if (dataPos + 64 + dataLength > hex.size()) {
+      throw std::runtime_error("Multicall: return data too short");
+    }
+    result.returnData = "0x" + hex.substr(dataPos + 64, dataLength);
+    ret.push_back(result);
+  }
+  return ret;
+}
+
+std::vector<Request> Multicall::buildRequests(
+  const std::vector<MulticallCall> &calls, uint64_t firstId, std::string block
+) {
+  std::vector<Request> reqs;
+  size_t start = 0;
+  for (size_t size : chunkSizes(calls)) {
+    std::vector<MulticallCall> chunk(calls.begin() + start, calls.begin() + start + size);
+    json params;
+    params["to"] = Multicall::address;
+    params["data"] = encodeAggregate3(chunk);
+    reqs.push_back({firstId + reqs.size(), "2.0", "eth_call", {params, block}});
+    start += size;
+  }
+  return reqs;
+}
+
+std::vector<MulticallResult> Multicall::parseResponses(
+  const std::vector<MulticallCall> &calls, json responses, uint64_t firstId
+) {
+  std::vector<MulticallResult> ret;
+  std::vector<size_t> sizes = chunkSizes(calls);
+  for (size_t i = 0; i < sizes.size(); i++) {
+    std::vector<MulticallResult> chunkResults;
+    // The API can return the answers in any order, so they're matched by id
+    for (json &resp : responses) {
+      if (!resp.is_object() || !resp.contains("id") || !resp["id"].is_number()) { continue; }
+      if (resp["id"].get<uint64_t>() != firstId + i) { continue; }
+      try {
+        chunkResults = decodeAggregate3(resp["result"].get<std::string>());
+      } catch (std::exception &e) {
+        Utils::logToDebug(std::string("Multicall ERROR: ") + e.what() + " - " + resp.dump());
+      }
+      break;
+    }
+    if (chunkResults.size() != sizes[i]) {
+      chunkResults.assign(sizes[i], MulticallResult{false, "0x", false});
+    }
+    ret.insert(ret.end(), chunkResults.begin(), chunkResults.end());
+  }
+  return ret;
+}
+
+std::vector<MulticallResult> Multicall::call(
+  const std::vector<MulticallCall> &calls, std::string block
+) {
+  // Queue every chunk first so they go together in a single batch
+  std::vector<Request> reqs = buildRequests(calls, 1, block);
+  std::vector<std::future<json>> futures;
+  for (Request &req : reqs) { futures.push_back(RPCBatcher::callFuture(req)); }
+  json responses = json::array();
+  for (std::future<json> &future : futures) { responses.push_back(future.get()); }
+  return parseResponses(calls, responses, 1);
+}
+
+void Multicall::setChunkLimits(uint64_t gas, uint64_t bytes) {
+  maxChunkGas = (gas > 0) ? gas : 1;
+  maxChunkBytes = (bytes > 0) ? bytes : 1;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef MULTICALL_H
+#define MULTICALL_H
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <vector>
+
+#include <core/ABI.h>
+#include <core/Utils.h>
+#include <network/API.h>
+#include <network/Pangolin.h>
+#include <network/RPCBatcher.h>
+
+// A single read call to be aggregated. gas = 0 uses Multicall's default estimate.
+typedef struct MulticallCall {
+  std::string target;
+  std::string callData;  // Hex, with "0x"
+  bool allowFailure;
+  uint64_t gas;
+} MulticallCall;
+
+/**
+ * The result of a single aggregated call. returnData is hex, with "0x".
+ * answered is false if the call's whole chunk failed (e.g. connection
+ * error), so a failed call can be told apart from one that reverted.
+ */
+typedef struct MulticallResult {
+  bool success;
+  std::string returnData;
+  bool answered;
+} MulticallResult;
+
+/**
+ * Aggregation of contract reads through Multicall3's aggregate3(), so
+ * hundreds of calls (balanceOf, allowance, name, symbol, decimals,
+ * getReserves, etc.) cost a single eth_call.
+ * Calls are split in chunks by their estimated gas and calldata size, so
+ * no chunk goes past what a node accepts for one eth_call. All chunks of
+ * a read are sent together in one JSON-RPC batch.
+ * See https://github.com/mds1/multicall for the contract.
+ */
+class Multicall {
+  private:
+    // Multicall3's address (same on every chain it's deployed to).
+    static std::string address;
+
+    // Chunk limits: total estimated gas, total calldata bytes and default gas per call.
+    static std::atomic<uint64_t> maxChunkGas;
+    static std::atomic<uint64_t> maxChunkBytes;
+    static std::atomic<uint64_t> defaultCallGas;
+
+    // Split the calls in chunks, returning the size of each chunk, in order.
+    static std::vector<size_t> chunkSizes(const std::vector<MulticallCall> &calls);
+
+  public:
+    // Build a call. Failures are allowed by default, so one bad call doesn't fail the others.
+    static MulticallCall makeCall(std::string target, std::string callData, bool allowFailure = true);
+
+    /**
+     * Encode calls as aggregate3((address,bool,bytes)[]) calldata.
+     * Returns the hex string, with "0x".
+     */
+    static std::string encodeAggregate3(const std::vector<MulticallCall> &calls);
+
+    /**
+     * Decode the return data of aggregate3() ((bool,bytes)[]).
+     * Throws if the data is malformed.
+     */
+    static std::vector<MulticallResult> decodeAggregate3(std::string hex);
+
+    /**
+     * Build the eth_call requests for all the calls (one per chunk),
+     * with ids starting at firstId, to be sent in a JSON-RPC batch.
+     */
+    static std::vector<Request> buildRequests(
+      const std::vector<MulticallCall> &calls, uint64_t firstId, std::string block = "latest"
+    );
+
+    /**
+     * Get the results for the calls out of a batch answer (an array of
+     * response objects) for the requests above, in the same order as the
+     * calls. Calls from chunks that failed are marked as not successful
+     * and not answered.
+     */
+    static std::vector<MulticallResult> parseResponses(
+      const std::vector<MulticallCall> &calls, json responses, uint64_t firstId
+    );
+
+    /**
+     * Make all the calls and wait for the results, in the same order.
+     * Goes through RPCBatcher, so it must NOT be called from a network thread.
+     */
+    static std::vector<MulticallResult> call(
+      const std::vector<MulticallCall> &calls, std::string block = "latest"
+    );
+
+    /**
+     * Set the chunk limits (estimated gas and calldata bytes per eth_call).
+     * Should be set before reading, as chunks are worked out again when parsing.
+     */
+    static void setChunkLimits(uint64_t gas, uint64_t bytes);
+};
+
+#endif  // MULTICALL_H
@@ -81,25 +81,38 @@ std::string Pangolin::getFirstFromPair(std::string tokenAddressA, std::string to
   return (valueA < valueB) ? tokenAddressA : tokenAddressB;
 }
 
+u256 Pangolin::calcExchangeAmountOut(
+  const u256 &amountIn, const u256 &reserveIn, const u256 &reserveOut
+) {
+  if (amountIn == 0 || reserveIn == 0 || reserveOut == 0) { return 0; }
+  // Products are done in 512 bits, so they can't overflow
+  u512 amountInWithFee = u512(amountIn) * 997;
+  u512 numerator = amountInWithFee * reserveOut;
+  u512 denominator = u512(reserveIn) * 1000 + amountInWithFee;
+  return u256(numerator / denominator);
+}
+
+u256 Pangolin::calcExchangeAmountIn(
+  const u256 &amountOut, const u256 &reserveIn, const u256 &reserveOut
+) {
+  if (amountOut == 0 || reserveIn == 0 || amountOut >= reserveOut) { return 0; }
+  u512 numerator = u512(reserveIn) * amountOut * 1000;
+  u512 denominator = u512(reserveOut - amountOut) * 997;
+  u512 amountIn = (numerator / denominator) + 1;
+  if (amountIn > u512(std::numeric_limits<u256>::max())) { return 0; }
+  return u256(amountIn);
+}
+
 std::string Pangolin::calcExchangeAmountOut(
   std::string amountIn, std::string reserveIn, std::string reserveOut
 ) {
-  u256 amountInU256 = boost::lexical_cast<u256>(amountIn);
   u256 reserveInU256 = boost::lexical_cast<u256>(reserveIn);
   u256 reserveOutU256 = boost::lexical_cast<u256>(reserveOut);
-
-  u256 amountInWithFee = amountInU256 * 997;
-  if ((amountInWithFee / 997) != amountInU256) { return ""; }  // Mul overflow
-
-  u256 numerator = amountInWithFee * reserveOutU256;
-  if ((numerator / reserveOutU256) != amountInWithFee) { return ""; }  // Mul overflow
-
-  u256 denominator = reserveInU256 * 1000;
-  if ((denominator / 1000) != reserveInU256) { return ""; }  // Mul overflow
-  if ((denominator + amountInWithFee) < denominator) { return ""; }  // Add overflow
-  denominator += amountInWithFee;
-
-  return boost::lexical_cast<std::string>(numerator / denominator);
+  if (reserveInU256 == 0 || reserveOutU256 == 0) { return ""; }  // No liquidity, no quote
+  u256 amountOut = calcExchangeAmountOut(
+    boost::lexical_cast<u256>(amountIn), reserveInU256, reserveOutU256
+  );
+  return boost::lexical_cast<std::string>(amountOut);
 }
 
 std::string Pangolin::calcLiquidityAmountOut(
@@ -5,6 +5,7 @@
 #define PANGOLIN_H
 
 #include <iostream>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -50,10 +51,24 @@ class Pangolin {
      */
     static std::string getFirstFromPair(std::string tokenAddressA, std::string tokenAddressB);
 
+    /**
+     * (LOCAL) Calculate the maximum output of a swap, or the minimum input
+     * needed for a given output, through a single pair (with the 0.3% fee).
+     * Amount and reserves are always in Wei.
+     * Returns 0 if the swap isn't possible (e.g. empty reserves).
+     */
+    static u256 calcExchangeAmountOut(
+      const u256 &amountIn, const u256 &reserveIn, const u256 &reserveOut
+    );
+    static u256 calcExchangeAmountIn(
+      const u256 &amountOut, const u256 &reserveIn, const u256 &reserveOut
+    );
+
     /**
      * (LOCAL) Calculate the maximum output for exchange and liquidity screens, respectively.
      * Amount and reserves are always in Wei.
-     * Returns the output in Wei, or empty if there's an under/overflow.
+     * Returns the output in Wei, or empty if there's no quote
+     * (exchange: empty reserves, liquidity: under/overflow).
      */
     static std::string calcExchangeAmountOut(
       std::string amountIn, std::string reserveIn, std::string reserveOut
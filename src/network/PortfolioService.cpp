@@ -0,0 +1,256 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "PortfolioService.h"
+
+std::string PortfolioService::address;
+std::vector<ARC20Token> PortfolioService::tokens;
+PortfolioHandler PortfolioService::handler;
+BlockSubscription PortfolioService::watcher(&PortfolioService::onBlock);
+bool PortfolioService::running = false;
+uint64_t PortfolioService::generation = 0;
+bool PortfolioService::refreshing = false;
+bool PortfolioService::refreshAgain = false;
+uint64_t PortfolioService::everyBlocks = 1;
+uint64_t PortfolioService::blocksSeen = 0;
+PortfolioSnapshot PortfolioService::last;
+bool PortfolioService::hasLast = false;
+std::string PortfolioService::prices;
+std::mutex PortfolioService::portfolioMutex;
+
+std::vector<MulticallCall> PortfolioService::balanceCalls(
+  std::string address, const std::vector<ARC20Token> &tokens
+) {
+  std::vector<MulticallCall> calls;
+  for (const ARC20Token &token : tokens) {
+    calls.push_back(Multicall::makeCall(
+      token.address, Pangolin::ERC20Funcs["balanceOf"] + Utils::addressToHex(address)
+    ));
+  }
+  return calls;
+}
+
+std::vector<Request> PortfolioService::buildRequests(
+  std::string address, const std::vector<ARC20Token> &tokens
+) {
+  std::vector<Request> reqs;
+  reqs.push_back({1, "2.0", "eth_getBalance", {address, "latest"}});
+  reqs.push_back({2, "2.0", "eth_baseFee", json::array()});
+  reqs.push_back({3, "2.0", "eth_getTransactionCount", {address, "latest"}});
+  if (!tokens.empty()) {
+    std::vector<Request> tokenReqs = Multicall::buildRequests(balanceCalls(address, tokens), 4);
+    reqs.insert(reqs.end(), tokenReqs.begin(), tokenReqs.end());
+  }
+  return reqs;
+}
+
+PortfolioSnapshot PortfolioService::parseSnapshot(
+  std::string address, const std::vector<ARC20Token> &tokens, json balances, json prices
+) {
+  PortfolioSnapshot snap;
+  bigfloat avaxUSDPrice = boost::lexical_cast<bigfloat>(Graph::parseAVAXPriceUSD(prices));
+  std::vector<MulticallResult> tokenBalances = Multicall::parseResponses(
+    balanceCalls(address, tokens), balances, 4
+  );
+  // The API can return the answers in any order, so they're matched by id
+  for (json &item : balances) {
+    uint64_t id = item["id"].get<uint64_t>();
+    if (id == 1) {
+      u256 avaxWeiBal = boost::lexical_cast<HexTo<u256>>(item["result"].get<std::string>());
+      std::string avaxBalStr = Utils::weiToFixedPoint(boost::lexical_cast<std::string>(avaxWeiBal), 18);
+      bigfloat avaxUSDBal = avaxUSDPrice * bigfloat(avaxBalStr);
+      std::stringstream avaxUSDBalPrec2;
+      avaxUSDBalPrec2 << std::setprecision(2) << std::fixed << avaxUSDBal;
+      std::stringstream avaxUSDPricePrec2;
+      avaxUSDPricePrec2 << std::setprecision(2) << std::fixed << avaxUSDPrice;
+      snap.coin["coinBalance"] = avaxBalStr;
+      snap.coin["coinFiatBalance"] = avaxUSDBalPrec2.str();
+      snap.coin["coinFiatPrice"] = avaxUSDPricePrec2.str();
+      snap.coin["coinPriceChart"] = prices["data"]["AVAXUSDCHART"].dump();
+    } else if (id == 2) {
+      // Gas price as Gwei
+      u256 gasPriceWei = boost::lexical_cast<HexTo<u256>>(Utils::jsonToStr(item["result"]));
+      snap.gasPrice = Utils::weiToFixedPoint(boost::lexical_cast<std::string>(gasPriceWei), 9);
+    } else if (id == 3) {
+      uint64_t nonce = boost::lexical_cast<HexTo<uint64_t>>(item["result"].get<std::string>());
+      snap.nonce = std::to_string(nonce);
+    }
+  }
+  for (size_t i = 0; i < tokens.size(); i++) {
+    const ARC20Token &token = tokens[i];
+    // Due to GraphQL limitations, ids are lowercase and prefixed
+    std::string tokenId = Utils::toLowerCaseAddress("token_" + token.address);
+    std::string chartId = Utils::toLowerCaseAddress("chart_" + token.address);
+    std::string tokenDerivedPriceStr = "0";
+    if (prices["data"][tokenId].type() != json::value_t::null) {
+      tokenDerivedPriceStr = prices["data"][tokenId]["derivedETH"].get<std::string>();
+    }
+    bigfloat tokenDerivedPrice = boost::lexical_cast<bigfloat>(tokenDerivedPriceStr);
+    // Failed or empty calls (e.g. not a token anymore) count as no balance
+    u256 tokenWeiBal = 0;
+    if (tokenBalances[i].success && tokenBalances[i].returnData.size() >= 66) {
+      u256 returned = boost::lexical_cast<HexTo<u256>>(tokenBalances[i].returnData.substr(0, 66));
+      tokenWeiBal = returned;
+    }
+    std::string tokenBalStr = Utils::weiToFixedPoint(
+      boost::lexical_cast<std::string>(tokenWeiBal), token.decimals
+    );
+    bigfloat tokenUSDPrice = tokenDerivedPrice * avaxUSDPrice;
+    bigfloat tokenUSDValueFloat = tokenUSDPrice * bigfloat(tokenBalStr);
+    std::stringstream ss;
+    ss << std::setprecision(2) << std::fixed << tokenUSDValueFloat;
+    json tokenInformation;
+    tokenInformation["tokenAddress"] = token.address;
+    tokenInformation["tokenSymbol"] = token.symbol;
+    tokenInformation["tokenDecimals"] = token.decimals;
+    tokenInformation["tokenName"] = token.name;
+    tokenInformation["tokenRawBalance"] = tokenBalStr;
+    tokenInformation["tokenFiatValue"] = ss.str();
+    tokenInformation["tokenDerivedValue"] = tokenDerivedPriceStr;
+    tokenInformation["tokenChartData"] = prices["data"][chartId].dump();
+    tokenInformation["tokenUSDPrice"] = boost::lexical_cast<std::string>(tokenUSDPrice);
+    snap.tokens[token.address] = tokenInformation;
+  }
+  return snap;
+}
+
+void PortfolioService::onBlock(uint64_t block) {
+  portfolioMutex.lock();
+  bool due = (++blocksSeen >= everyBlocks);
+  if (due) { blocksSeen = 0; }
+  portfolioMutex.unlock();
+  if (due) { refresh(); }
+}
+
+void PortfolioService::refresh() {
+  portfolioMutex.lock();
+  if (!running) { portfolioMutex.unlock(); return; }
+  // Only one refresh at a time, blocks that arrive meanwhile are folded into one more
+  if (refreshing) {
+    refreshAgain = true;
+    portfolioMutex.unlock();
+    return;
+  }
+  refreshing = true;
+  uint64_t gen = generation;
+  std::string addressStr = address;
+  std::vector<ARC20Token> tokenList = tokens;
+  portfolioMutex.unlock();
+
+  // Balances and prices are asked for at the same time, whichever answer
+  // arrives last finishes the refresh (prices are usually local already)
+  auto balancesResp = std::make_shared<std::string>();
+  auto pricesResp = std::make_shared<std::string>();
+  auto pending = std::make_shared<std::atomic<int>>(2);
+  API::httpGetRequestAsync(API::buildMultiRequest(buildRequests(addressStr, tokenList)), [=](std::string resp){
+    *balancesResp = resp;
+    if (--(*pending) == 0) { finish(gen, *balancesResp, *pricesResp); }
+  });
+  PriceStore::getAccountPrices(tokenList, [=](std::string resp){
+    *pricesResp = resp;
+    if (--(*pending) == 0) { finish(gen, *balancesResp, *pricesResp); }
+  });
+}
+
+void PortfolioService::finish(uint64_t gen, std::string balancesResp, std::string pricesResp) {
+  portfolioMutex.lock();
+  bool current = (running && gen == generation);
+  if (current && !pricesResp.empty()) { prices = pricesResp; }
+  std::string addressStr = address;
+  std::vector<ARC20Token> tokenList = tokens;
+  std::string pricesStr = prices;
+  portfolioMutex.unlock();
+
+  PortfolioSnapshot snap;
+  bool parsed = false;
+  if (current) {
+    try {
+      snap = parseSnapshot(addressStr, tokenList, json::parse(balancesResp), json::parse(pricesStr));
+      parsed = true;
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("PortfolioService ERROR: ") + e.what());
+    }
+  }
+
+  // Keep only what changed since the last snapshot
+  json changedTokens = json::array();
+  json changedCoin;
+  std::string changedGasPrice, changedNonce;
+  bool full = false, changed = false, again = false;
+  PortfolioHandler toCall;
+  portfolioMutex.lock();
+  refreshing = false;
+  // The Account or token list changed while this was in flight, try again
+  again = refreshAgain || (running && gen != generation);
+  refreshAgain = false;
+  if (parsed && running && gen == generation) {
+    full = !hasLast;
+    for (std::pair<const std::string, json> &token : snap.tokens) {
+      auto it = last.tokens.find(token.first);
+      if (full || it == last.tokens.end() || it->second != token.second) {
+        changedTokens.push_back(token.second);
+      }
+    }
+    if (full || snap.coin != last.coin) { changedCoin = snap.coin; }
+    if (full || snap.gasPrice != last.gasPrice) { changedGasPrice = snap.gasPrice; }
+    if (full || snap.nonce != last.nonce) { changedNonce = snap.nonce; }
+    changed = (full || !changedTokens.empty() || !changedCoin.is_null()
+      || !changedGasPrice.empty() || !changedNonce.empty());
+    last = snap;
+    hasLast = true;
+    toCall = handler;
+  }
+  portfolioMutex.unlock();
+
+  if (changed && toCall) {
+    try {
+      toCall(addressStr, changedTokens, changedCoin, changedGasPrice, changedNonce, full);
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("PortfolioService handler ERROR: ") + e.what());
+    }
+  }
+  if (again) { refresh(); }
+}
+
+void PortfolioService::start(std::string address, std::vector<ARC20Token> tokens, PortfolioHandler handler) {
+  portfolioMutex.lock();
+  PortfolioService::address = address;
+  PortfolioService::tokens = tokens;
+  PortfolioService::handler = handler;
+  generation++;
+  hasLast = false;
+  last = PortfolioSnapshot();
+  prices.clear();  // Prices depend on the token list
+  blocksSeen = 0;
+  running = true;
+  watcher.start();
+  portfolioMutex.unlock();
+  refresh();
+}
+
+void PortfolioService::stop() {
+  portfolioMutex.lock();
+  running = false;
+  generation++;
+  hasLast = false;
+  last = PortfolioSnapshot();
+  handler = nullptr;
+  watcher.stop();
+  portfolioMutex.unlock();
+}
+
+void PortfolioService::setTokens(std::vector<ARC20Token> tokens) {
+  portfolioMutex.lock();
+  PortfolioService::tokens = tokens;
+  generation++;
+  hasLast = false;
+  prices.clear();
+  portfolioMutex.unlock();
+  refresh();
+}
+
+void PortfolioService::setBlockInterval(uint64_t blocks) {
+  portfolioMutex.lock();
+  everyBlocks = (blocks > 0) ? blocks : 1;
+  portfolioMutex.unlock();
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef PORTFOLIOSERVICE_H
+#define PORTFOLIOSERVICE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <core/Utils.h>
+#include <network/API.h>
+#include <network/BlockWatcher.h>
+#include <network/Graph.h>
+#include <network/Multicall.h>
+#include <network/PriceStore.h>
+
+// An Account's balances: tokens (by address), coin, gas price (in Gwei) and nonce.
+typedef struct PortfolioSnapshot {
+  std::map<std::string, json> tokens;
+  json coin;
+  std::string gasPrice;
+  std::string nonce;
+} PortfolioSnapshot;
+
+/**
+ * Callback for portfolio updates, called from a network thread.
+ * Receives the Account's address and only what changed since the last
+ * update: an array of token information, the coin information (null if
+ * unchanged), the gas price and the nonce (empty if unchanged).
+ * "full" is true when everything is sent (e.g. the first update after
+ * starting or changing the token list).
+ */
+typedef std::function<void(
+  std::string address, json tokens, json coin,
+  std::string gasPrice, std::string nonce, bool full
+)> PortfolioHandler;
+
+/**
+ * Keeps the current Account's balances up to date and pushes changes.
+ * Balances (coin, tokens, gas price and nonce) are asked for in one
+ * JSON-RPC batch once every N new blocks from BlockWatcher, instead of on
+ * a fixed timer. Fiat prices and their 31-day charts come from PriceStore,
+ * which answers from local data and only asks for what's missing or stale.
+ * Each result is compared with the previous one and only the differences
+ * are given to the handler, so an idle Account costs nothing past the
+ * balances request itself.
+ */
+class PortfolioService {
+  private:
+    // The Account being watched, its tokens and who gets the updates.
+    static std::string address;
+    static std::vector<ARC20Token> tokens;
+    static PortfolioHandler handler;
+
+    // BlockWatcher subscription, and whether the service is running.
+    static BlockSubscription watcher;
+    static bool running;
+
+    // Bumped on every start/stop/token change, so old answers are thrown away.
+    static uint64_t generation;
+
+    // Whether a refresh is in flight, and if another one was asked meanwhile.
+    static bool refreshing;
+    static bool refreshAgain;
+
+    // Refresh every this many blocks, and blocks seen since the last refresh.
+    static uint64_t everyBlocks;
+    static uint64_t blocksSeen;
+
+    // Last snapshot sent to the handler.
+    static PortfolioSnapshot last;
+    static bool hasLast;
+
+    // Last fiat prices answer, used if PriceStore has none at the moment.
+    static std::string prices;
+
+    // Mutex for all the members above.
+    static std::mutex portfolioMutex;
+
+    // Called by BlockWatcher for each new block.
+    static void onBlock(uint64_t block);
+
+    // Parse the balances and prices of a refresh, then send what changed.
+    static void finish(uint64_t gen, std::string balancesResp, std::string pricesResp);
+
+  public:
+    // Get the balanceOf() calls for an Account's tokens, in the same order as the list.
+    static std::vector<MulticallCall> balanceCalls(
+      std::string address, const std::vector<ARC20Token> &tokens
+    );
+
+    /**
+     * Build the balance requests for an Account and its tokens.
+     * Coin balance is id 1, gas price is id 2, nonce is id 3 and token
+     * balances come after, aggregated through Multicall (one id per chunk).
+     */
+    static std::vector<Request> buildRequests(
+      std::string address, const std::vector<ARC20Token> &tokens
+    );
+
+    /**
+     * Parse the answers for the requests above and the prices (from
+     * PriceStore::getAccountPrices) into a snapshot.
+     * Throws if either answer is malformed.
+     */
+    static PortfolioSnapshot parseSnapshot(
+      std::string address, const std::vector<ARC20Token> &tokens, json balances, json prices
+    );
+
+    /**
+     * Start watching an Account (or switch to another one) with the given
+     * tokens. A full update is sent as soon as the first refresh is done.
+     */
+    static void start(std::string address, std::vector<ARC20Token> tokens, PortfolioHandler handler);
+
+    // Stop watching. Answers still in flight are thrown away.
+    static void stop();
+
+    // Change the token list (e.g. after adding/removing a token), sending a full update.
+    static void setTokens(std::vector<ARC20Token> tokens);
+
+    // Refresh right away instead of waiting for the next block(s).
+    static void refresh();
+
+    // Set how many blocks to wait between refreshes (1 = every block).
+    static void setBlockInterval(uint64_t blocks);
+};
+
+#endif  // PORTFOLIOSERVICE_H
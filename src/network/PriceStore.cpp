@@ -0,0 +1,236 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "PriceStore.h"
+
+DBTable PriceStore::table;
+json PriceStore::spot = json::object();
+std::chrono::steady_clock::time_point PriceStore::spotTime;
+std::map<std::string, PriceStore::DaySync> PriceStore::daySyncs;
+std::chrono::seconds PriceStore::spotInterval = std::chrono::seconds(60);
+std::chrono::seconds PriceStore::daysInterval = std::chrono::seconds(600);
+bool PriceStore::refreshing = false;
+std::mutex PriceStore::storeMutex;
+const std::string PriceStore::avaxToken = "0xb31f66aa3c1e785363f0875a1b74e27b85fd66c7";
+
+// The Graph's daily data is keyed by the start of the day (UTC).
+static uint64_t today() {
+  return (uint64_t(std::time(nullptr)) / 86400) * 86400;
+}
+
+std::string PriceStore::dayKey(std::string token, uint64_t date) {
+  std::string key = token + "/";
+  for (int i = 7; i >= 0; i--) { key += char((date >> (i * 8)) & 0xFF); }
+  return key;
+}
+
+json PriceStore::readDays(std::string token, int days) {
+  json ret = json::array();
+  size_t dateStart = token.size() + 1;
+  table.scan([&](const std::string &key, const std::string &value){
+    if (key.size() != dateStart + 8) { return true; }
+    uint64_t date = 0;
+    for (size_t i = dateStart; i < key.size(); i++) { date = (date << 8) | uint8_t(key[i]); }
+    json row;
+    row["date"] = date;
+    row["priceUSD"] = value;
+    ret.push_back(row);
+    return (ret.size() < size_t(days));
+  }, token + "/", token + "0", true);
+  return ret;
+}
+
+void PriceStore::plan(
+  bool wantSpot, const std::vector<std::string> &spotTokens, const std::vector<std::string> &dayTokens,
+  int days, bool &withSpot, std::map<std::string, uint64_t> &since, bool &mustWait
+) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  uint64_t needFrom = today() - (uint64_t(days > 0 ? days : 1) - 1) * 86400;
+  withSpot = mustWait = false;
+  storeMutex.lock();
+  if (wantSpot) {
+    withSpot = (now - spotTime >= spotInterval);
+    if (!spot.contains("USDAVAX")) { withSpot = mustWait = true; }
+    for (const std::string &token : spotTokens) {
+      if (!spot.contains("token_" + token)) { withSpot = mustWait = true; }
+    }
+  }
+  for (const std::string &token : dayTokens) {
+    auto sync = daySyncs.find(token);
+    bool synced = (sync != daySyncs.end());
+    if (synced && now - sync->second.time < daysInterval && sync->second.days >= days) { continue; }
+    // Find the newest and oldest stored days
+    uint64_t newest = 0, oldest = 0;
+    json newestRow = readDays(token, 1);
+    if (!newestRow.empty()) { newest = newestRow[0]["date"].get<uint64_t>(); }
+    table.scan([&](const std::string &key, const std::string &value){
+      for (size_t i = token.size() + 1; i < key.size(); i++) { oldest = (oldest << 8) | uint8_t(key[i]); }
+      return false;
+    }, token + "/", token + "0");
+    if (newest == 0 && !synced) { mustWait = true; }
+    // Only the newest day is still changing, unless older days are missing
+    bool covered = (newest != 0 && (oldest <= needFrom || (synced && sync->second.days >= days)));
+    since[token] = (covered) ? newest : needFrom;
+  }
+  storeMutex.unlock();
+}
+
+std::string PriceStore::buildQuery(
+  bool withSpot, const std::vector<std::string> &spotTokens,
+  const std::map<std::string, uint64_t> &since
+) {
+  std::stringstream query;
+  query << "{";
+  if (withSpot) {
+    query << "USDAVAX: pair(id: \"0xe28984e1ee8d431346d32bec9ec800efb643eef4\")"
+          << "{token0 {symbol} token1 {symbol} token0Price token1Price}";
+    for (const std::string &token : spotTokens) {
+      query << "token_" << token << ": token(id: \"" << token << "\"){symbol derivedETH}";
+    }
+  }
+  for (const std::pair<const std::string, uint64_t> &day : since) {
+    query << "days_" << day.first << ": tokenDayDatas(first: 1000, orderBy: date, orderDirection: desc, where: {"
+          << "token: \"" << day.first << "\", date_gte: " << day.second << "}) { date priceUSD }";
+  }
+  query << "}";
+  json body;
+  body["query"] = query.str();
+  return body.dump();
+}
+
+void PriceStore::storeAnswer(
+  std::string resp, bool withSpot, const std::map<std::string, uint64_t> &since, int days
+) {
+  json data;
+  try {
+    data = json::parse(resp)["data"];
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("PriceStore ERROR: ") + e.what());
+    return;
+  }
+  if (!data.is_object()) {
+    Utils::logToDebug("PriceStore ERROR: " + resp);
+    return;
+  }
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  DBBatch batch;
+  storeMutex.lock();
+  if (withSpot && data.contains("USDAVAX") && !data["USDAVAX"].is_null()) {
+    for (json::iterator it = data.begin(); it != data.end(); ++it) {
+      if (it.key() == "USDAVAX" || it.key().substr(0, 6) == "token_") { spot[it.key()] = it.value(); }
+    }
+    spotTime = now;
+  }
+  for (const std::pair<const std::string, uint64_t> &day : since) {
+    json rows = data["days_" + day.first];
+    if (!rows.is_array()) { continue; }
+    try {
+      for (json &row : rows) {
+        batch.putValue(table, dayKey(day.first, row["date"].get<uint64_t>()), row["priceUSD"].get<std::string>());
+      }
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("PriceStore ERROR: ") + e.what());
+      continue;
+    }
+    DaySync &sync = daySyncs[day.first];
+    sync.days = std::max(sync.days, days);
+    sync.time = now;
+  }
+  if (batch.size() > 0) { table.write(batch); }
+  storeMutex.unlock();
+}
+
+std::string PriceStore::localPrices(const std::vector<std::string> &tokens) {
+  json data;
+  storeMutex.lock();
+  if (!spot.contains("USDAVAX")) {
+    storeMutex.unlock();
+    return "";
+  }
+  data["USDAVAX"] = spot["USDAVAX"];
+  for (const std::string &token : tokens) {
+    data["token_" + token] = (spot.contains("token_" + token)) ? spot["token_" + token] : json();
+    data["chart_" + token] = readDays(token, chartDays);
+  }
+  data["AVAXUSDCHART"] = readDays(avaxToken, chartDays);
+  storeMutex.unlock();
+  json ret;
+  ret["data"] = data;
+  return ret.dump();
+}
+
+void PriceStore::setTable(DBTable table) {
+  storeMutex.lock();
+  PriceStore::table = table;
+  daySyncs.clear();
+  storeMutex.unlock();
+}
+
+void PriceStore::getAccountPrices(std::vector<ARC20Token> tokens, ResponseHandler handler) {
+  // The Graph only knows lowercase addresses
+  std::vector<std::string> addresses;
+  for (ARC20Token &token : tokens) { addresses.push_back(Utils::toLowerCaseAddress(token.address)); }
+  std::vector<std::string> dayTokens = addresses;
+  dayTokens.push_back(avaxToken);
+
+  bool withSpot, mustWait;
+  std::map<std::string, uint64_t> since;
+  plan(true, addresses, dayTokens, chartDays, withSpot, since, mustWait);
+  if (!withSpot && since.empty()) {
+    handler(localPrices(addresses));
+    return;
+  }
+  std::string query = buildQuery(withSpot, addresses, since);
+  if (mustWait) {
+    Graph::httpGetRequestAsync(query, [=](std::string resp){
+      if (!resp.empty()) { storeAnswer(resp, withSpot, since, chartDays); }
+      handler(localPrices(addresses));
+    });
+    return;
+  }
+
+  // Answer with what's stored and refresh in the background, once at a time
+  storeMutex.lock();
+  bool start = !refreshing;
+  refreshing = true;
+  storeMutex.unlock();
+  if (start) {
+    Graph::httpGetRequestAsync(query, [=](std::string resp){
+      if (!resp.empty()) { storeAnswer(resp, withSpot, since, chartDays); }
+      storeMutex.lock();
+      refreshing = false;
+      storeMutex.unlock();
+    });
+  }
+  handler(localPrices(addresses));
+}
+
+json PriceStore::getAccountPrices(std::vector<ARC20Token> tokens) {
+  auto promise = std::make_shared<std::promise<std::string>>();
+  std::future<std::string> future = promise->get_future();
+  getAccountPrices(tokens, [promise](std::string resp){ promise->set_value(resp); });
+  std::string resp = future.get();
+  return (resp.empty()) ? json::object() : json::parse(resp);
+}
+
+json PriceStore::getTokenPriceHistory(std::string address, int days) {
+  std::string token = Utils::toLowerCaseAddress(address);
+  bool withSpot, mustWait;
+  std::map<std::string, uint64_t> since;
+  plan(false, {}, {token}, days, withSpot, since, mustWait);
+  if (!since.empty()) {
+    std::string resp = Graph::httpGetRequest(buildQuery(false, {}, since));
+    if (!resp.empty()) { storeAnswer(resp, false, since, days); }
+  }
+  storeMutex.lock();
+  json ret = readDays(token, days);
+  storeMutex.unlock();
+  return ret;
+}
+
+void PriceStore::setIntervals(uint64_t spotSeconds, uint64_t daysSeconds) {
+  storeMutex.lock();
+  spotInterval = std::chrono::seconds(spotSeconds);
+  daysInterval = std::chrono::seconds(daysSeconds);
+  storeMutex.unlock();
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef PRICESTORE_H
+#define PRICESTORE_H
+
+#include <chrono>
+#include <ctime>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <core/DBTable.h>
+#include <core/Utils.h>
+#include <network/Graph.h>
+
+/**
+ * Local store of the fiat prices used for balances and charts.
+ * Daily prices (the Graph's tokenDayDatas) are kept per token in LevelDB,
+ * so only the days that are missing (plus the newest one, which is still
+ * changing) are ever asked for again.
+ * Spot prices (the AVAX-USD pair and each token's derivedETH) are kept in
+ * memory for a while. Once something is stored, every request is answered
+ * from local data right away, and anything stale is refreshed in the
+ * background with a single GraphQL query.
+ */
+class PriceStore {
+  private:
+    // Where the daily prices are stored (keyed by token + big-endian date).
+    static DBTable table;
+
+    // Spot prices, in the same format as in the Graph's answer ("USDAVAX" and "token_<address>").
+    static json spot;
+    static std::chrono::steady_clock::time_point spotTime;
+
+    // When each token's daily prices were last asked for, and for how many days.
+    typedef struct DaySync {
+      std::chrono::steady_clock::time_point time;
+      int days;
+    } DaySync;
+    static std::map<std::string, DaySync> daySyncs;
+
+    // How long spot prices and the newest day are kept before asking again.
+    static std::chrono::seconds spotInterval;
+    static std::chrono::seconds daysInterval;
+
+    // Whether a background refresh is in flight.
+    static bool refreshing;
+
+    // Mutex for all the members above.
+    static std::mutex storeMutex;
+
+    // Get the key for a token's day.
+    static std::string dayKey(std::string token, uint64_t date);
+
+    // Get a token's stored days, newest first, as {date, priceUSD}. Caller must hold storeMutex.
+    static json readDays(std::string token, int days);
+
+    /**
+     * Work out what must be asked for: spot prices (if wanted, for AVAX and
+     * the given tokens) and, for each token that needs it, the first day to
+     * ask for. mustWait is set if there's nothing stored to answer with yet.
+     */
+    static void plan(
+      bool wantSpot, const std::vector<std::string> &spotTokens, const std::vector<std::string> &dayTokens,
+      int days, bool &withSpot, std::map<std::string, uint64_t> &since, bool &mustWait
+    );
+
+    // Build the GraphQL query for the plan above.
+    static std::string buildQuery(
+      bool withSpot, const std::vector<std::string> &spotTokens,
+      const std::map<std::string, uint64_t> &since
+    );
+
+    // Store the answer for the query above.
+    static void storeAnswer(
+      std::string resp, bool withSpot, const std::map<std::string, uint64_t> &since, int days
+    );
+
+    /**
+     * Build the prices for the given tokens from local data, in the same
+     * format as Graph::getAccountPrices(). Returns an empty string if
+     * there's no AVAX price yet.
+     */
+    static std::string localPrices(const std::vector<std::string> &tokens);
+
+  public:
+    // WAVAX's address, used for AVAX's daily prices.
+    static const std::string avaxToken;
+
+    // How many days the account charts show.
+    static const int chartDays = 31;
+
+    // Set the table to store daily prices in. Give it a closed table before closing the database.
+    static void setTable(DBTable table);
+
+    /**
+     * Get AVAX's and the given tokens' prices and charts, in the same format
+     * as Graph::getAccountPrices(). The handler is called right away from
+     * local data if there's any, otherwise from a network thread once the
+     * prices arrive (with an empty string at connection failure).
+     */
+    static void getAccountPrices(std::vector<ARC20Token> tokens, ResponseHandler handler);
+
+    /**
+     * Same as above, but blocks until the prices are available.
+     * Must NOT be called from a network thread.
+     */
+    static json getAccountPrices(std::vector<ARC20Token> tokens);
+
+    /**
+     * Get a token's daily prices for the last X days, newest first, in the
+     * same format as Graph::getTokenPriceHistory(). Only missing days are
+     * asked for. Must NOT be called from a network thread.
+     */
+    static json getTokenPriceHistory(std::string address, int days);
+
+    // Set how long (in seconds) spot prices and the newest day are kept before asking again.
+    static void setIntervals(uint64_t spotSeconds, uint64_t daysSeconds);
+};
+
+#endif  // PRICESTORE_H
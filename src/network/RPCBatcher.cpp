@@ -0,0 +1,184 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "RPCBatcher.h"
+
+std::deque<std::shared_ptr<RPCBatcher::Call>> RPCBatcher::queues[2];
+std::unique_ptr<boost::asio::steady_timer> RPCBatcher::timers[2];
+bool RPCBatcher::timerArmed[2] = {false, false};
+std::map<std::string, std::shared_ptr<RPCBatcher::Call>> RPCBatcher::inFlight;
+std::chrono::microseconds RPCBatcher::window = std::chrono::microseconds(3000);
+size_t RPCBatcher::maxBatch = 20;
+std::mutex RPCBatcher::batchMutex;
+
+bool RPCBatcher::isDedupable(std::string method) {
+  return !(
+    method.rfind("eth_send", 0) == 0 ||
+    method.rfind("eth_sign", 0) == 0 ||
+    method.rfind("personal_", 0) == 0 ||
+    method.find("ubscribe") != std::string::npos ||
+    method.find("Filter") != std::string::npos
+  );
+}
+
+void RPCBatcher::callAsync(std::string method, json params, RPCHandler handler, bool isWebSocket) {
+  std::vector<std::shared_ptr<Call>> batch;
+  int idx = (isWebSocket) ? 1 : 0;
+
+  // Answer from the cache if this block already has the result
+  json cached;
+  if (RPCCache::lookup(idx, method, params, cached)) {
+    try {
+      handler(cached);
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("RPC batch handler ERROR: ") + e.what());
+    }
+    return;
+  }
+
+  std::string key = "";
+  if (isDedupable(method)) {
+    key = std::to_string(idx) + method + params.dump();
+  }
+
+  batchMutex.lock();
+  // Same call already on its way, just wait for its answer
+  if (!key.empty()) {
+    auto it = inFlight.find(key);
+    if (it != inFlight.end()) {
+      it->second->waiters.push_back(handler);
+      batchMutex.unlock();
+      return;
+    }
+  }
+  std::shared_ptr<Call> call = std::make_shared<Call>();
+  call->method = method;
+  call->params = params;
+  call->key = key;
+  call->waiters.push_back(handler);
+  if (!key.empty()) { inFlight[key] = call; }
+  queues[idx].push_back(call);
+
+  if (queues[idx].size() >= maxBatch) {
+    // Batch is full, send it right away
+    batch.assign(queues[idx].begin(), queues[idx].end());
+    queues[idx].clear();
+  } else if (!timerArmed[idx]) {
+    // First call in the window, flush when it ends
+    if (timers[idx] == nullptr) {
+      timers[idx].reset(new boost::asio::steady_timer(AsyncClient::getContext()));
+    }
+    timerArmed[idx] = true;
+    timers[idx]->expires_after(window);
+    timers[idx]->async_wait([isWebSocket](boost::system::error_code ec){
+      if (ec != boost::asio::error::operation_aborted) { flush(isWebSocket); }
+    });
+  }
+  batchMutex.unlock();
+
+  if (!batch.empty()) { send(batch, isWebSocket); }
+}
+
+void RPCBatcher::flush(bool isWebSocket) {
+  std::vector<std::shared_ptr<Call>> batch;
+  int idx = (isWebSocket) ? 1 : 0;
+  batchMutex.lock();
+  timerArmed[idx] = false;
+  batch.assign(queues[idx].begin(), queues[idx].end());
+  queues[idx].clear();
+  batchMutex.unlock();
+  if (!batch.empty()) { send(batch, isWebSocket); }
+}
+
+void RPCBatcher::send(std::vector<std::shared_ptr<Call>> batch, bool isWebSocket) {
+  // Ids are the call's position in the batch (starting at 1)
+  std::vector<Request> reqs;
+  for (size_t i = 0; i < batch.size(); i++) {
+    reqs.push_back({i + 1, "2.0", batch[i]->method, batch[i]->params});
+  }
+  std::string query = API::buildMultiRequest(reqs);
+  if (reqs.size() == 1) {
+    // No need to wrap a single call in an array
+    query = json::parse(query)[0].dump();
+  }
+
+  API::httpGetRequestAsync(query, [batch, isWebSocket](std::string resp){
+    // Map each answer to its id. Anything missing gets an error instead.
+    std::map<uint64_t, json> answers;
+    try {
+      json respJson = json::parse(resp);
+      if (!respJson.is_array()) { respJson = json::array({respJson}); }
+      for (json &item : respJson) {
+        if (item.contains("id") && item["id"].is_number_unsigned()) {
+          answers[item["id"].get<uint64_t>()] = item;
+        }
+      }
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("RPC batch ERROR: ") + e.what());
+    }
+
+    for (size_t i = 0; i < batch.size(); i++) {
+      json answer;
+      auto it = answers.find(i + 1);
+      if (it != answers.end()) {
+        answer = it->second;
+      } else {
+        answer["jsonrpc"] = "2.0";
+        answer["error"]["code"] = -32603;
+        answer["error"]["message"] = "Internal error";
+      }
+      // A new block makes "latest" results stale, so check it before caching
+      if (batch[i]->method == "eth_blockNumber" && answer.contains("result")) {
+        try {
+          RPCCache::onBlock(boost::lexical_cast<HexTo<uint64_t>>(answer["result"].get<std::string>()));
+        } catch (std::exception &e) {}
+      }
+      RPCCache::store(isWebSocket ? 1 : 0, batch[i]->method, batch[i]->params, answer);
+
+      // Stop deduping before taking the waiters, so no one is left behind
+      batchMutex.lock();
+      if (!batch[i]->key.empty()) {
+        auto inFlightIt = inFlight.find(batch[i]->key);
+        if (inFlightIt != inFlight.end() && inFlightIt->second == batch[i]) {
+          inFlight.erase(inFlightIt);
+        }
+      }
+      std::vector<RPCHandler> waiters = std::move(batch[i]->waiters);
+      batchMutex.unlock();
+      for (RPCHandler &waiter : waiters) {
+        try {
+          waiter(answer);
+        } catch (std::exception &e) {
+          Utils::logToDebug(std::string("RPC batch handler ERROR: ") + e.what());
+        }
+      }
+    }
+  }, isWebSocket);
+}
+
+json RPCBatcher::call(Request req, bool isWebSocket) {
+  return callFuture(req, isWebSocket).get();
+}
+
+std::future<json> RPCBatcher::callFuture(Request req, bool isWebSocket) {
+  auto promise = std::make_shared<std::promise<json>>();
+  std::future<json> ret = promise->get_future();
+  uint64_t id = req.id;
+  callAsync(req.method, req.params, [promise, id](json resp){
+    resp["id"] = id;
+    promise->set_value(resp);
+  }, isWebSocket);
+  return ret;
+}
+
+void RPCBatcher::setWindow(uint64_t microseconds) {
+  batchMutex.lock();
+  window = std::chrono::microseconds(microseconds);
+  batchMutex.unlock();
+}
+
+void RPCBatcher::setMaxBatch(size_t size) {
+  batchMutex.lock();
+  maxBatch = (size > 0) ? size : 1;
+  batchMutex.unlock();
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef RPCBATCHER_H
+#define RPCBATCHER_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include <network/API.h>
+#include <network/AsyncClient.h>
+#include <network/RPCCache.h>
+#include <lib/nlohmann_json/json.hpp>
+
+// For convenience.
+using json = nlohmann::json;
+
+// Callback for batched calls. Receives the JSON-RPC response object for the
+// call, with either a "result" or an "error" field. The "id" is not meaningful.
+typedef std::function<void(json)> RPCHandler;
+
+/**
+ * Dispatcher that coalesces independent JSON-RPC calls into batches.
+ * Calls issued within a short window (or until a max number of calls is
+ * queued) are sent together as one JSON-RPC batch request, and each answer
+ * is routed back to its caller by id.
+ * Identical read-only calls (same endpoint, method and params) that are
+ * already queued or in flight are not sent again, their callers share the
+ * same answer instead.
+ * Read-only calls are answered from RPCCache when possible, and every answer
+ * is offered to it (block numbers seen in eth_blockNumber invalidate it).
+ */
+class RPCBatcher {
+  private:
+    // A queued/in-flight call and everyone waiting for its answer.
+    typedef struct Call {
+      std::string method;
+      json params;
+      std::string key;  // Dedupe key, empty if the call can't be deduped
+      std::vector<RPCHandler> waiters;
+    } Call;
+
+    // Queued calls and flush timer for each endpoint (index 0 = API, 1 = WebSocket API).
+    static std::deque<std::shared_ptr<Call>> queues[2];
+    static std::unique_ptr<boost::asio::steady_timer> timers[2];
+    static bool timerArmed[2];
+
+    // Calls that can be deduped, while queued or in flight.
+    static std::map<std::string, std::shared_ptr<Call>> inFlight;
+
+    // Batching window and max number of calls per batch.
+    static std::chrono::microseconds window;
+    static size_t maxBatch;
+
+    // Mutex for all the members above.
+    static std::mutex batchMutex;
+
+    /**
+     * Check if a method is safe to dedupe (i.e. it's a read without side effects).
+     * Transactions, signatures, filters and subscriptions are always sent as is.
+     */
+    static bool isDedupable(std::string method);
+
+    // Send everything queued for an endpoint. Called by the timer.
+    static void flush(bool isWebSocket);
+
+    // Send a batch of calls and route the answers back to their waiters.
+    static void send(std::vector<std::shared_ptr<Call>> batch, bool isWebSocket);
+
+  public:
+    /**
+     * Queue a call to be sent in the next batch. The handler is called from
+     * a network thread with the call's response object. At connection
+     * failure, the response has a JSON-RPC "Internal error" instead.
+     * Cached answers call the handler right away, from the caller's thread.
+     */
+    static void callAsync(std::string method, json params, RPCHandler handler, bool isWebSocket = false);
+
+    /**
+     * Same as above, but blocks until the answer arrives and returns the
+     * response object with the request's id.
+     * Must NOT be called from a network thread (e.g. inside an async
+     * handler), as that thread is needed to deliver the answer.
+     */
+    static json call(Request req, bool isWebSocket = false);
+
+    // Same as above, but returns a future with the response object instead.
+    static std::future<json> callFuture(Request req, bool isWebSocket = false);
+
+    // Set the batching window (in microseconds) and the max number of calls per batch.
+    static void setWindow(uint64_t microseconds);
+    static void setMaxBatch(size_t size);
+};
+
+#endif  // RPCBATCHER_H
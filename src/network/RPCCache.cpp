@@ -0,0 +1,185 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "RPCCache.h"
+
+std::list<RPCCache::Entry> RPCCache::lru;
+std::unordered_map<std::string, std::list<RPCCache::Entry>::iterator> RPCCache::index;
+size_t RPCCache::maxBytes = 8 * 1024 * 1024;
+size_t RPCCache::curBytes = 0;
+std::chrono::milliseconds RPCCache::latestTTL = std::chrono::milliseconds(2000);
+std::chrono::milliseconds RPCCache::shortTTL = std::chrono::milliseconds(1000);
+uint64_t RPCCache::lastBlock = 0;
+std::atomic<uint64_t> RPCCache::hits(0);
+std::atomic<uint64_t> RPCCache::misses(0);
+std::atomic<uint64_t> RPCCache::evictions(0);
+std::atomic<uint64_t> RPCCache::invalidations(0);
+std::mutex RPCCache::cacheMutex;
+
+RPCCache::Scope RPCCache::scopeOf(std::string method, json &params) {
+  // Methods that don't depend on a block tag
+  if (method == "eth_chainId" || method == "net_version") { return FIXED; }
+  if (method == "eth_blockNumber") { return SHORT; }
+  if (method == "eth_gasPrice" || method == "eth_baseFee" || method == "eth_maxPriorityFeePerGas") {
+    return LATEST;
+  }
+  // Transactions are FIXED only once mined, see store()
+  if (method == "eth_getTransactionReceipt" || method == "eth_getTransactionByHash" ||
+    method == "eth_getBlockByHash"
+  ) {
+    return FIXED;
+  }
+
+  // Methods with a block tag, and the tag's position in the params
+  static const std::unordered_map<std::string, size_t> tagPos = {
+    {"eth_call", 1}, {"eth_estimateGas", 1}, {"eth_getBalance", 1},
+    {"eth_getCode", 1}, {"eth_getTransactionCount", 1}, {"eth_getStorageAt", 2},
+    {"eth_getBlockByNumber", 0}, {"eth_getBlockTransactionCountByNumber", 0}
+  };
+  auto it = tagPos.find(method);
+  if (it == tagPos.end()) { return NONE; }
+  if (params.is_null()) { params = json::array(); }
+  if (!params.is_array()) { return NONE; }
+  if (params.size() < it->second) { return NONE; }
+  if (params.size() == it->second) { params.push_back("latest"); }  // Implied tag
+  const json &tag = params[it->second];
+  if (tag.is_object()) { return FIXED; }  // EIP-1898 block hash/number object
+  if (!tag.is_string()) { return NONE; }
+  std::string tagStr = tag.get<std::string>();
+  if (tagStr == "pending") { return NONE; }
+  if (tagStr == "latest" || tagStr == "safe" || tagStr == "finalized") { return LATEST; }
+  if (tagStr == "earliest" || tagStr.substr(0, 2) == "0x") { return FIXED; }
+  return NONE;
+}
+
+json RPCCache::canonicalize(json params) {
+  if (params.is_string()) {
+    std::string str = params.get<std::string>();
+    if (str.substr(0, 2) == "0x" || str.substr(0, 2) == "0X") {
+      std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+      return str;
+    }
+    return params;
+  }
+  if (params.is_array() || params.is_object()) {
+    for (auto &item : params) { item = canonicalize(item); }
+  }
+  return params;
+}
+
+void RPCCache::erase(std::list<Entry>::iterator it) {
+  curBytes -= it->bytes;
+  index.erase(it->key);
+  lru.erase(it);
+}
+
+bool RPCCache::lookup(int endpoint, std::string method, json params, json &response) {
+  Scope scope = scopeOf(method, params);
+  if (scope == NONE) { return false; }
+  std::string key = std::to_string(endpoint) + method + canonicalize(params).dump();
+
+  cacheMutex.lock();
+  auto it = index.find(key);
+  if (it == index.end()) {
+    cacheMutex.unlock();
+    misses++;
+    return false;
+  }
+  if (it->second->scope != FIXED && std::chrono::steady_clock::now() > it->second->expiresAt) {
+    erase(it->second);
+    cacheMutex.unlock();
+    misses++;
+    return false;
+  }
+  lru.splice(lru.begin(), lru, it->second); // Move to the front
+  response = json::object();
+  response["jsonrpc"] = "2.0";
+  response["result"] = lru.front().result;
+  cacheMutex.unlock();
+  hits++;
+  return true;
+}
+
+void RPCCache::store(int endpoint, std::string method, json params, json response) {
+  // Errors and empty results are never cached
+  if (!response.is_object() || response.contains("error")) { return; }
+  if (!response.contains("result") || response["result"].is_null()) { return; }
+  Scope scope = scopeOf(method, params);
+  if (scope == NONE) { return; }
+  // Transactions only stop changing once mined, pending ones are never cached
+  if (method == "eth_getTransactionReceipt" || method == "eth_getTransactionByHash") {
+    const json &result = response["result"];
+    if (!result.is_object() || !result.contains("blockHash") || result["blockHash"].is_null()) {
+      return;
+    }
+  }
+
+  Entry entry;
+  entry.key = std::to_string(endpoint) + method + canonicalize(params).dump();
+  entry.result = response["result"];
+  entry.bytes = entry.key.size() + entry.result.dump().size() + sizeof(Entry);
+  entry.scope = scope;
+  entry.expiresAt = std::chrono::steady_clock::now()
+    + ((scope == SHORT) ? shortTTL : latestTTL);
+
+  cacheMutex.lock();
+  if (entry.bytes > maxBytes) { cacheMutex.unlock(); return; }
+  auto it = index.find(entry.key);
+  if (it != index.end()) { erase(it->second); }
+  curBytes += entry.bytes;
+  lru.push_front(std::move(entry));
+  index[lru.front().key] = lru.begin();
+  while (curBytes > maxBytes && !lru.empty()) {
+    erase(std::prev(lru.end()));
+    evictions++;
+  }
+  cacheMutex.unlock();
+}
+
+void RPCCache::onBlock(uint64_t blockNumber) {
+  cacheMutex.lock();
+  if (blockNumber <= lastBlock) { cacheMutex.unlock(); return; }
+  lastBlock = blockNumber;
+  for (auto it = lru.begin(); it != lru.end();) {
+    auto next = std::next(it);
+    if (it->scope != FIXED) {
+      erase(it);
+      invalidations++;
+    }
+    it = next;
+  }
+  cacheMutex.unlock();
+}
+
+RPCCacheStats RPCCache::getStats() {
+  RPCCacheStats stats;
+  stats.hits = hits;
+  stats.misses = misses;
+  stats.evictions = evictions;
+  stats.invalidations = invalidations;
+  cacheMutex.lock();
+  stats.entries = lru.size();
+  stats.bytes = curBytes;
+  stats.maxBytes = maxBytes;
+  stats.lastBlock = lastBlock;
+  cacheMutex.unlock();
+  return stats;
+}
+
+void RPCCache::setMaxBytes(size_t bytes) {
+  cacheMutex.lock();
+  maxBytes = bytes;
+  while (curBytes > maxBytes && !lru.empty()) {
+    erase(std::prev(lru.end()));
+    evictions++;
+  }
+  cacheMutex.unlock();
+}
+
+void RPCCache::clear() {
+  cacheMutex.lock();
+  lru.clear();
+  index.clear();
+  curBytes = 0;
+  cacheMutex.unlock();
+}
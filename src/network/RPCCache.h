@@ -0,0 +1,119 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef RPCCACHE_H
+#define RPCCACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <core/Utils.h>
+#include <lib/nlohmann_json/json.hpp>
+
+// For convenience.
+using json = nlohmann::json;
+
+// Struct for the cache's counters, as returned by RPCCache::getStats().
+typedef struct RPCCacheStats {
+  uint64_t hits;          // Calls answered from the cache
+  uint64_t misses;        // Cacheable calls that had to go to the node
+  uint64_t evictions;     // Entries dropped to stay under the memory cap
+  uint64_t invalidations; // Entries dropped because a new block was seen
+  uint64_t entries;       // Entries currently stored
+  uint64_t bytes;         // Approximate memory used by the stored entries
+  uint64_t maxBytes;      // Memory cap
+  uint64_t lastBlock;     // Highest block number seen so far
+} RPCCacheStats;
+
+/**
+ * Cache for the results of read-only eth_* calls, keyed by endpoint, method
+ * and canonicalized params (which include the block tag).
+ * - Calls at "latest" (explicit or implied) are dropped as soon as a new
+ *   block number is seen, and also after a short TTL in case no one asks
+ *   for the block number in the meantime.
+ * - Calls at an explicit block number/hash (or "earliest") never change,
+ *   so they're only dropped by LRU eviction.
+ * - Calls at "pending", errors and unknown methods are never cached.
+ * Memory is capped, the least recently used entries are evicted first.
+ */
+class RPCCache {
+  private:
+    // How long a result stays valid.
+    enum Scope { NONE, LATEST, FIXED, SHORT };
+
+    typedef struct Entry {
+      std::string key;
+      json result;
+      size_t bytes;
+      Scope scope;
+      std::chrono::steady_clock::time_point expiresAt;
+    } Entry;
+
+    // Entries, most recently used at the front, and an index by key.
+    static std::list<Entry> lru;
+    static std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+    // Memory cap, current usage and the TTLs for LATEST and SHORT entries.
+    static size_t maxBytes;
+    static size_t curBytes;
+    static std::chrono::milliseconds latestTTL;
+    static std::chrono::milliseconds shortTTL;
+
+    // Highest block number seen so far.
+    static uint64_t lastBlock;
+
+    // Counters.
+    static std::atomic<uint64_t> hits;
+    static std::atomic<uint64_t> misses;
+    static std::atomic<uint64_t> evictions;
+    static std::atomic<uint64_t> invalidations;
+
+    // Mutex for all the members above.
+    static std::mutex cacheMutex;
+
+    /**
+     * Check if a call can be cached, and for how long.
+     * Fills in the implied "latest" block tag if the call omits it.
+     */
+    static Scope scopeOf(std::string method, json &params);
+
+    // Lowercase every hex string, so the same call with different casing shares an entry.
+    static json canonicalize(json params);
+
+    // Remove an entry. Needs cacheMutex locked.
+    static void erase(std::list<Entry>::iterator it);
+
+  public:
+    /**
+     * Look for a cached result for the given call.
+     * Returns true and fills the response object ("jsonrpc" and "result")
+     * if there's a valid one.
+     */
+    static bool lookup(int endpoint, std::string method, json params, json &response);
+
+    // Store a call's response object, if it can be cached.
+    static void store(int endpoint, std::string method, json params, json response);
+
+    /**
+     * Tell the cache a block number was seen (e.g. from eth_blockNumber).
+     * If it's newer than the last one, every "latest" entry is dropped.
+     */
+    static void onBlock(uint64_t blockNumber);
+
+    // Get the cache's counters.
+    static RPCCacheStats getStats();
+
+    // Set the memory cap (in bytes). Evicts entries right away if needed.
+    static void setMaxBytes(size_t bytes);
+
+    // Drop every entry.
+    static void clear();
+};
+
+#endif  // RPCCACHE_H
@@ -3,6 +3,7 @@
 // file LICENSE or http://www.opensource.org/licenses/mit-license.php.
 
 #include "Server.h"
+#include "SubscriptionHub.h"
 
 #include <qmlwrap/QmlSystem.h> // https://stackoverflow.com/a/4964508
 
@@ -13,6 +14,8 @@ void session::run() {
 }
 
 void session::close() {
+  executor_->removeQueue(this);
+  SubscriptionHub::unsubscribeAll(this);
   m_lock.lock();
   if (ws_.is_open()) { // Check if it is even open before closing
     ws_.async_close(websocket::close_code::normal,beast::bind_front_handler(&session::on_closed, shared_from_this()));
@@ -36,6 +39,15 @@ void session::on_run() {
 
   // Insert the session to the list of sessions.
   sessions_->insert(shared_from_this());
+  // Create the session's queue. If it fills up, reading is paused until
+  // the executor drains it, then resumed in the session's strand.
+  std::weak_ptr<session> weak = shared_from_this();
+  executor_->addQueue(this, [weak](){
+    std::shared_ptr<session> self = weak.lock();
+    if (self) {
+      net::post(self->ws_.get_executor(), beast::bind_front_handler(&session::do_read, self));
+    }
+  });
   // Accept the websocket handshake
   ws_.async_accept(beast::bind_front_handler(&session::on_accept, shared_from_this()));
 }
@@ -52,36 +64,64 @@ void session::do_read() {
 void session::on_read(beast::error_code ec, std::size_t bytes_transferred) {
   boost::ignore_unused(bytes_transferred);
   //std::cout << "Request received!" << std::endl;
-  if (ec == websocket::error::closed) { Server::fail(ec, "read"); return; } // This indicates the session was closed
-  if (ec.value() == 125) { Server::fail(ec, "read"); return; } // Operation cancelled
-  if (ec.value() == 995) { Server::fail(ec, "read"); return; } // Interrupted by host
-  if (ec) { Server::fail(ec, "read"); }
-  // Send the message for another thread to parse it.
+  if (ec) {
+    // Closed (websocket::error::closed), cancelled (125), interrupted
+    // by host (995) or anything else, the session is done either way
+    Server::fail(ec, "read");
+    executor_->removeQueue(this);
+    SubscriptionHub::unsubscribeAll(this);
+    return;
+  }
+  // Pass the message to our handler through the executor. It runs in one
+  // of the executor's workers, so requests waiting for user input don't
+  // need a thread of their own.
   //std::cout << "Passing it to our handler" << std::endl;
-  // Run in another thread natively.
-  QtConcurrent::run(sys_, &QmlSystem::handleServer,boost::beast::buffers_to_string(buffer_.data()),shared_from_this());
+  std::string message = boost::beast::buffers_to_string(buffer_.data());
   buffer_.consume(buffer_.size());
-  do_read();
+  std::shared_ptr<session> self = shared_from_this();
+  bool hasRoom = executor_->submit(this, [self, message](){
+    return self->sys_->handleServer(message, self);
+  });
+  if (hasRoom) { do_read(); }
 }
 
 void session::do_write(std::string response) {
-  m_lock.lock();
-  if (ws_.is_open()) { // Check if the stream is open, before commiting to it.
-    // Copy string to buffer
-    answerBuffer_.consume(answerBuffer_.size());
-    size_t n = boost::asio::buffer_copy(answerBuffer_.prepare(response.size()), boost::asio::buffer(response));
-    answerBuffer_.commit(n);
-    // Write to the socket
-    ws_.async_write(answerBuffer_.data(), beast::bind_front_handler(
-      &session::on_write, shared_from_this()
-    ));
-  }
-  m_lock.unlock();
+  // Messages are shared and never change, so queueing one is just a pointer copy
+  std::shared_ptr<const std::string> message = std::make_shared<const std::string>(std::move(response));
+  net::post(ws_.get_executor(), [self = shared_from_this(), message](){
+    if (!self->ws_.is_open() || self->closing_) { return; } // Check if the stream is open, before commiting to it.
+    if (self->writeQueue_.size() >= maxWriteQueue_) {
+      Utils::logToDebug("Session write queue full, closing it");
+      // The front message is still being written, only the ones behind it can go
+      self->writeQueue_.erase(self->writeQueue_.begin() + 1, self->writeQueue_.end());
+      self->closing_ = true;
+      return;
+    }
+    self->writeQueue_.push_back(message);
+    // Only one write can be in flight, the others are chained from on_write
+    if (self->writeQueue_.size() == 1) { self->write_next(); }
+  });
+}
+
+void session::write_next() {
+  ws_.async_write(net::buffer(*writeQueue_.front()), beast::bind_front_handler(
+    &session::on_write, shared_from_this()
+  ));
 }
 
 void session::on_write(beast::error_code ec, std::size_t bytes_transferred) {
   boost::ignore_unused(bytes_transferred);
-  if (ec) { return Server::fail(ec, "write"); }
+  if (ec) {
+    writeQueue_.clear();
+    return Server::fail(ec, "write");
+  }
+  if (!writeQueue_.empty()) { writeQueue_.pop_front(); }
+  if (closing_) {
+    writeQueue_.clear();
+    close();
+    return;
+  }
+  if (!writeQueue_.empty()) { write_next(); }
 }
 
 void Server::listener::run() {
@@ -105,7 +145,7 @@ void Server::listener::on_accept(beast::error_code ec, tcp::socket socket) {
     return; // Close the listener regardless of the error
   } else {
     if (socket.remote_endpoint().address().to_string() == "127.0.0.1") {
-      std::make_shared<session>(std::move(socket),sessions_,sys_)->run();
+      std::make_shared<session>(std::move(socket),sessions_,sys_,executor_)->run();
     }
   }
   m_lock.unlock();
@@ -128,7 +168,7 @@ void Server::start() {
   running.lock();
   ioc.restart();
   std::make_shared<listener>(
-    ioc, tcp::endpoint{this->address, this->port}, &sessions_, &listeners_, sys_
+    ioc, tcp::endpoint{this->address, this->port}, &sessions_, &listeners_, sys_, &executor
   )->run();
   std::vector<std::thread> v;
   v.reserve(this->threads - 1);
@@ -12,6 +12,7 @@
 #include <boost/asio/strand.hpp>
 #include <algorithm>
 #include <cstdlib>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -20,6 +21,8 @@
 #include <vector>
 #include <unordered_set>
 
+#include <network/BridgeExecutor.h>
+
 class QmlSystem;  // https://stackoverflow.com/a/4964508
 
 namespace beast = boost::beast;
@@ -35,9 +38,18 @@ using tcp = boost::asio::ip::tcp;
 // Handles all received WebSocket messages.
 class session : public std::enable_shared_from_this<session> {
   QmlSystem* sys_;  // Pointer to QmlSystem
+  BridgeExecutor* executor_;  // Pointer to the Server's request executor
   beast::flat_buffer buffer_;
-  beast::flat_buffer answerBuffer_;
   websocket::stream<beast::tcp_stream> ws_;
+  // Outgoing messages, only touched from the session's strand.
+  // The front one is being written, the rest wait for their turn.
+  std::deque<std::shared_ptr<const std::string>> writeQueue_;
+  // Max messages waiting to be written before the session is dropped
+  // (the DApp isn't reading what it's sent).
+  static const size_t maxWriteQueue_ = 4096;
+  // Set when the queue overflows, so the session is closed once the
+  // write in flight finishes (its buffer must live until then).
+  bool closing_ = false;
   // Pointer to list of sessions.
   // Session needs access to it so it can insert itself in the list.
   std::unordered_set<std::shared_ptr<session>> *sessions_;
@@ -48,8 +60,8 @@ class session : public std::enable_shared_from_this<session> {
     explicit session(
       tcp::socket&& socket,
       std::unordered_set<std::shared_ptr<session>> *sessions,
-      QmlSystem *sys
-    ) : ws_(std::move(socket)), sessions_(sessions), sys_(sys) {}
+      QmlSystem *sys, BridgeExecutor *executor
+    ) : ws_(std::move(socket)), sessions_(sessions), sys_(sys), executor_(executor) {}
 
     /**
      * Get on the correct executor.
@@ -74,13 +86,20 @@ class session : public std::enable_shared_from_this<session> {
     // Read a message into the buffer.
     void do_read();
 
-    // Pass the message to the proper parser and listen for more.
+    // Queue the message for the executor and listen for more,
+    // unless the session's queue is full (then reading resumes once it drains).
     void on_read(beast::error_code ec, std::size_t bytes_transferred);
 
-    // Send a message
+    /**
+     * Send a message. Can be called from any thread: the message is queued
+     * in the session's strand and written after the ones before it.
+     */
     void do_write(std::string response);
 
-    // Catch errors over writing a message.
+    // Start writing the message at the front of the queue.
+    void write_next();
+
+    // Drop the written message and start the next one, if any.
     void on_write(beast::error_code ec, std::size_t bytes_transferred);
 };
 
@@ -88,6 +107,7 @@ class Server {
   // Accepts incoming connections and launches the sessions.
   class listener : public std::enable_shared_from_this<listener> {
     QmlSystem* sys_;  // Pointer to QmlSystem
+    BridgeExecutor* executor_;  // Pointer to the Server's request executor
     net::io_context& ioc_;
     tcp::acceptor acceptor_;
     // Pointer to the list of sessions.
@@ -104,8 +124,9 @@ class Server {
         net::io_context& ioc, tcp::endpoint endpoint,
         std::unordered_set<std::shared_ptr<session>> *sessions,
         std::unordered_set<std::shared_ptr<listener>> *listeners,
-        QmlSystem *sys
-      ) : ioc_(ioc), acceptor_(ioc), sessions_(sessions), listeners_(listeners), sys_(sys) {
+        QmlSystem *sys, BridgeExecutor *executor
+      ) : ioc_(ioc), acceptor_(ioc), sessions_(sessions), listeners_(listeners),
+        sys_(sys), executor_(executor) {
         beast::error_code ec;
         acceptor_.open(endpoint.protocol(), ec);  // Open the acceptor
         if (ec) { fail(ec, "open"); return; }
@@ -152,6 +173,9 @@ class Server {
     // Mutex to wait until server was succesfully stopped.
     std::mutex running;
 
+    // Runs the requests from all sessions with a fixed number of workers.
+    BridgeExecutor executor;
+
   public:
     // Create and launch a listening port, and run the I/O service.
     // The io_context is required for all I/O.
@@ -163,6 +187,9 @@ class Server {
     // Set a pointer to the QmlSystem object.
     void setQmlSystem(QmlSystem* sys);
 
+    // Get the request executor's queue and latency metrics.
+    BridgeStats getStats() { return this->executor.getStats(); }
+
     // Set a port to the server.
     void setPort(unsigned short desiredPort) { this->port = desiredPort; };
 
@@ -32,9 +32,7 @@ std::string Staking::totalSupply() {
   array.push_back(params);
   array.push_back("latest");
   Request req{1, "2.0", "eth_call", array};
-  std::string query = API::buildRequest(req);
-  std::string resp = API::httpGetRequest(query);
-  json respJson = json::parse(resp);
+  json respJson = RPCBatcher::call(req);
   std::string result = respJson["result"].get<std::string>();
   if (result == "0x" || result == "") { return {}; }
   result = result.substr(2); // Remove the "0x"
@@ -49,9 +47,7 @@ std::string Staking::getRewardForDuration() {
   array.push_back(params);
   array.push_back("latest");
   Request req{1, "2.0", "eth_call", array};
-  std::string query = API::buildRequest(req);
-  std::string resp = API::httpGetRequest(query);
-  json respJson = json::parse(resp);
+  json respJson = RPCBatcher::call(req);
   std::string result = respJson["result"].get<std::string>();
   if (result == "0x" || result == "") { return {}; }
   result = result.substr(2); // Remove the "0x"
@@ -66,9 +62,7 @@ std::string Staking::rewardsDuration() {
   array.push_back(params);
   array.push_back("latest");
   Request req{1, "2.0", "eth_call", array};
-  std::string query = API::buildRequest(req);
-  std::string resp = API::httpGetRequest(query);
-  json respJson = json::parse(resp);
+  json respJson = RPCBatcher::call(req);
   std::string result = respJson["result"].get<std::string>();
   if (result == "0x" || result == "") { return {}; }
   result = result.substr(2); // Remove the "0x"
@@ -83,9 +77,7 @@ std::string Staking::balanceOf(std::string address) {
   array.push_back(params);
   array.push_back("latest");
   Request req{1, "2.0", "eth_call", array};
-  std::string query = API::buildRequest(req);
-  std::string resp = API::httpGetRequest(query);
-  json respJson = json::parse(resp);
+  json respJson = RPCBatcher::call(req);
   std::string result = respJson["result"].get<std::string>();
   if (result == "0x" || result == "") { return {}; }
   result = result.substr(2); // Remove the "0x"
@@ -100,9 +92,7 @@ std::string Staking::earned(std::string address) {
   array.push_back(params);
   array.push_back("latest");
   Request req{1, "2.0", "eth_call", array};
-  std::string query = API::buildRequest(req);
-  std::string resp = API::httpGetRequest(query);
-  json respJson = json::parse(resp);
+  json respJson = RPCBatcher::call(req);
   std::string result = respJson["result"].get<std::string>();
   if (result == "0x" || result == "") { return {}; }
   result = result.substr(2); // Remove the "0x"
@@ -117,9 +107,7 @@ std::string Staking::getCompoundReward() {
   array.push_back(params);
   array.push_back("latest");
   Request req{1, "2.0", "eth_call", array};
-  std::string query = API::buildRequest(req);
-  std::string resp = API::httpGetRequest(query);
-  json respJson = json::parse(resp);
+  json respJson = RPCBatcher::call(req);
   std::string result = respJson["result"].get<std::string>();
   if (result == "0x" || result == "") { return {}; }
   result = result.substr(2); // Remove the "0x"
@@ -149,9 +137,7 @@ std::string Staking::compoundWithdraw(std::string amount) {
   array.push_back(params);
   array.push_back("latest");
   Request req{1, "2.0", "eth_call", array};
-  std::string query = API::buildRequest(req);
-  std::string resp = API::httpGetRequest(query);
-  json respJson = json::parse(resp);
+  json respJson = RPCBatcher::call(req);
   std::string result = respJson["result"].get<std::string>();
   if (result == "0x" || result == "") { return {}; }
   result = result.substr(2); // Remove the "0x"
@@ -5,6 +5,7 @@
 #define STAKING_H
 
 #include "Pangolin.h"
+#include "RPCBatcher.h"
 
 /**
  * Class for staking-related functions (e.g. stake/unstake LP, harvest, etc.).
@@ -0,0 +1,209 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "SubscriptionHub.h"
+
+std::map<std::string, SubscriptionHub::Subscription> SubscriptionHub::subscriptions;
+BlockSubscription SubscriptionHub::watcher(&SubscriptionHub::onBlock);
+uint64_t SubscriptionHub::lastBlock = 0;
+std::mutex SubscriptionHub::hubMutex;
+
+// Format a block number as a JSON-RPC quantity (e.g. "0x1a").
+static std::string toQuantity(uint64_t value) {
+  std::stringstream ss;
+  ss << "0x" << std::hex << value;
+  return ss.str();
+}
+
+std::string SubscriptionHub::subscribe(
+  std::string type, json filter, const void* owner, SubscriptionSink sink
+) {
+  if (type != "newHeads" && type != "logs") { return ""; }
+  Subscription sub;
+  sub.type = type;
+  sub.owner = owner;
+  sub.sink = sink;
+  if (type == "logs" && filter.is_object()) {
+    if (filter.contains("address")) {
+      json address = filter["address"];
+      if (address.is_string()) { address = json::array({address}); }
+      for (json &a : address) {
+        if (!a.is_string()) { continue; }
+        std::string addr = a.get<std::string>();
+        boost::algorithm::to_lower(addr);
+        sub.addresses.push_back(addr);
+      }
+    }
+    if (filter.contains("topics") && filter["topics"].is_array()) { sub.topics = filter["topics"]; }
+  }
+  std::string id = "0x" + dev::h128::random().hex();
+
+  hubMutex.lock();
+  subscriptions[id] = sub;
+  if (!watcher.isActive()) {
+    lastBlock = BlockWatcher::getLastBlock();
+    watcher.start();
+  }
+  hubMutex.unlock();
+  return id;
+}
+
+bool SubscriptionHub::unsubscribe(std::string id, const void* owner) {
+  hubMutex.lock();
+  auto it = subscriptions.find(id);
+  bool ret = (it != subscriptions.end() && it->second.owner == owner);
+  if (ret) { subscriptions.erase(it); }
+  hubMutex.unlock();
+  return ret;
+}
+
+void SubscriptionHub::unsubscribeAll(const void* owner) {
+  hubMutex.lock();
+  for (auto it = subscriptions.begin(); it != subscriptions.end();) {
+    it = (it->second.owner == owner) ? subscriptions.erase(it) : std::next(it);
+  }
+  hubMutex.unlock();
+}
+
+void SubscriptionHub::onBlock(uint64_t block) {
+  bool withHeads = false;
+  bool withLogs = false;
+  bool anyAddress = false;
+  std::set<std::string> addresses;
+  uint64_t fromBlock;
+  hubMutex.lock();
+  // No one left, stop watching blocks
+  if (subscriptions.empty()) {
+    watcher.stop();
+    hubMutex.unlock();
+    return;
+  }
+  for (std::pair<const std::string, Subscription> &sub : subscriptions) {
+    if (sub.second.type == "newHeads") { withHeads = true; continue; }
+    withLogs = true;
+    if (sub.second.addresses.empty()) { anyAddress = true; }
+    addresses.insert(sub.second.addresses.begin(), sub.second.addresses.end());
+  }
+  // Blocks already handed out are never asked for again, even if they're still in flight
+  fromBlock = std::max(lastBlock + 1, (block >= maxBlocksBehind) ? block - maxBlocksBehind + 1 : 0);
+  if (lastBlock == 0) { fromBlock = block; }
+  lastBlock = std::max(lastBlock, block);
+  hubMutex.unlock();
+  if (fromBlock > block) { return; }
+
+  // Headers and logs for all subscribers come in one batch
+  std::vector<Request> reqs;
+  uint64_t id = 1;
+  if (withLogs) {
+    json filter;
+    filter["fromBlock"] = toQuantity(fromBlock);
+    filter["toBlock"] = toQuantity(block);
+    if (!anyAddress) { filter["address"] = json(addresses); }
+    reqs.push_back({id++, "2.0", "eth_getLogs", {filter}});
+  }
+  if (withHeads) {
+    for (uint64_t b = fromBlock; b <= block; b++) {
+      reqs.push_back({id++, "2.0", "eth_getBlockByNumber", {toQuantity(b), false}});
+    }
+  }
+  uint64_t headCount = (withHeads) ? block - fromBlock + 1 : 0;
+  API::httpGetRequestAsync(API::buildMultiRequest(reqs), [withLogs, headCount](std::string resp){
+    onData(withLogs, headCount, resp);
+  });
+}
+
+void SubscriptionHub::onData(bool withLogs, uint64_t headCount, std::string resp) {
+  // Logs are always id 1 if they were asked for, then the headers in order
+  json logs = json::array();
+  std::vector<json> heads;
+  try {
+    json respJson = json::parse(resp);
+    if (!respJson.is_array()) { respJson = json::array({respJson}); }
+    std::map<uint64_t, json> answers;
+    for (json &item : respJson) {
+      if (item.contains("id") && item["id"].is_number_unsigned() && item.contains("result")) {
+        answers[item["id"].get<uint64_t>()] = item["result"];
+      }
+    }
+    uint64_t firstHead = 1;
+    if (withLogs) {
+      if (answers.count(1) && answers[1].is_array()) { logs = answers[1]; }
+      firstHead = 2;
+    }
+    for (uint64_t id = firstHead; id < firstHead + headCount; id++) {
+      // A header that failed doesn't hold back the ones after it
+      auto it = answers.find(id);
+      if (it == answers.end() || !it->second.is_object()) {
+        Utils::logToDebug("SubscriptionHub: missing header for request " + std::to_string(id));
+        continue;
+      }
+      json head = it->second;
+      // Same shape as a newHeads notification: just the header
+      head.erase("transactions");
+      head.erase("uncles");
+      heads.push_back(head);
+    }
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("SubscriptionHub ERROR: ") + e.what());
+    return;
+  }
+
+  // Build every notification first, deliver them outside the lock
+  std::vector<std::pair<SubscriptionSink, std::string>> toSend;
+  hubMutex.lock();
+  for (std::pair<const std::string, Subscription> &sub : subscriptions) {
+    if (sub.second.type == "newHeads") {
+      for (json &head : heads) { toSend.push_back({sub.second.sink, notification(sub.first, head)}); }
+    } else {
+      for (json &log : logs) {
+        if (matches(sub.second, log)) { toSend.push_back({sub.second.sink, notification(sub.first, log)}); }
+      }
+    }
+  }
+  hubMutex.unlock();
+  for (std::pair<SubscriptionSink, std::string> &n : toSend) {
+    try {
+      n.first(n.second);
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("SubscriptionHub sink ERROR: ") + e.what());
+    }
+  }
+}
+
+bool SubscriptionHub::matches(const Subscription &sub, const json &log) {
+  if (!sub.addresses.empty()) {
+    std::string address = log.value("address", "");
+    boost::algorithm::to_lower(address);
+    if (std::find(sub.addresses.begin(), sub.addresses.end(), address) == sub.addresses.end()) {
+      return false;
+    }
+  }
+  if (!sub.topics.is_array()) { return true; }
+  json logTopics = log.value("topics", json::array());
+  for (size_t i = 0; i < sub.topics.size(); i++) {
+    const json &wanted = sub.topics[i];
+    if (wanted.is_null()) { continue; }  // Any topic in this position
+    if (i >= logTopics.size() || !logTopics[i].is_string()) { return false; }
+    std::string topic = logTopics[i].get<std::string>();
+    boost::algorithm::to_lower(topic);
+    bool found = false;
+    json options = (wanted.is_array()) ? wanted : json::array({wanted});
+    for (const json &option : options) {
+      if (!option.is_string()) { continue; }
+      std::string opt = option.get<std::string>();
+      boost::algorithm::to_lower(opt);
+      if (opt == topic) { found = true; break; }
+    }
+    if (!found) { return false; }
+  }
+  return true;
+}
+
+std::string SubscriptionHub::notification(std::string id, const json &result) {
+  json ret;
+  ret["jsonrpc"] = "2.0";
+  ret["method"] = "eth_subscription";
+  ret["params"]["subscription"] = id;
+  ret["params"]["result"] = result;
+  return ret.dump();
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef SUBSCRIPTIONHUB_H
+#define SUBSCRIPTIONHUB_H
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include <network/API.h>
+#include <network/BlockWatcher.h>
+
+// Callback for delivering a notification (a full JSON-RPC message) to a subscriber.
+typedef std::function<void(std::string)> SubscriptionSink;
+
+/**
+ * eth_subscribe support for the DApps connected to the wallet.
+ * All subscriptions share one upstream: BlockWatcher's block poller.
+ * For every new block, the headers (for "newHeads") and the logs (for
+ * "logs", filtered upstream by the union of every subscription's
+ * addresses) are asked for in one JSON-RPC batch, then each subscription's
+ * own filter is applied locally before notifying it.
+ * So any number of connected DApps costs one upstream request per block.
+ */
+class SubscriptionHub {
+  private:
+    // A subscription, who owns it (e.g. a session), and where it's delivered.
+    typedef struct Subscription {
+      std::string type;  // "newHeads" or "logs"
+      std::vector<std::string> addresses;  // Lowercase, empty = any
+      json topics;  // Same format as in eth_getLogs, null = any
+      const void* owner;
+      SubscriptionSink sink;
+    } Subscription;
+
+    // Subscriptions by id.
+    static std::map<std::string, Subscription> subscriptions;
+
+    // BlockWatcher subscription, and the last block already handed out.
+    static BlockSubscription watcher;
+    static uint64_t lastBlock;
+
+    // Mutex for all the members above.
+    static std::mutex hubMutex;
+
+    // Max blocks delivered at once, if the poller falls behind.
+    static const uint64_t maxBlocksBehind = 10;
+
+    // Ask for the new blocks' headers and logs.
+    static void onBlock(uint64_t block);
+
+    // Deliver the headers (headCount of them were asked for) and logs to the matching subscriptions.
+    static void onData(bool withLogs, uint64_t headCount, std::string resp);
+
+    // Check if a log matches a subscription's filter.
+    static bool matches(const Subscription &sub, const json &log);
+
+    // Build an eth_subscription notification.
+    static std::string notification(std::string id, const json &result);
+
+  public:
+    /**
+     * Create a subscription ("newHeads" or "logs", with an optional
+     * filter with "address" and/or "topics").
+     * Returns the subscription id, or an empty string if the type is unknown.
+     */
+    static std::string subscribe(
+      std::string type, json filter, const void* owner, SubscriptionSink sink
+    );
+
+    // Remove a subscription. Only its owner can remove it.
+    static bool unsubscribe(std::string id, const void* owner);
+
+    // Remove all subscriptions from an owner (e.g. when a session closes).
+    static void unsubscribeAll(const void* owner);
+};
+
+#endif  // SUBSCRIPTIONHUB_H
@@ -0,0 +1,249 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "SwapRouter.h"
+
+// WAVAX, AVME, PNG, USDT.e, USDC.e and DAI.e
+std::vector<std::string> SwapRouter::baseTokens = {
+  "0xb31f66aa3c1e785363f0875a1b74e27b85fd66c7",
+  "0x1ecd47ff4d9598f89721a2866bfeb99505a413ed",
+  "0x60781c2586d68229fde47564546784ab3faca982",
+  "0xc7198437980c041c805a1edcba50c1ce5db95118",
+  "0xa7d7079b0fead91f3e65f86e8915cb59c1a4c664",
+  "0xd586e7f844cea2f87f50152665bcbc2c279d8d70",
+};
+std::vector<std::string> SwapRouter::tokens;
+std::shared_ptr<const SwapGraph> SwapRouter::graph;
+BlockSubscription SwapRouter::watcher(&SwapRouter::onBlock);
+bool SwapRouter::running = false;
+uint64_t SwapRouter::generation = 0;
+bool SwapRouter::discovered = false;
+bool SwapRouter::refreshing = false;
+std::mutex SwapRouter::routerMutex;
+
+std::string SwapRouter::normalize(std::string token) {
+  std::string ret = Utils::toLowerCaseAddress(token);
+  if (ret == "0xeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeee") {
+    ret = Utils::toLowerCaseAddress(Pangolin::contracts["AVAX"]);
+  }
+  return ret;
+}
+
+void SwapRouter::onBlock(uint64_t block) { refresh(); }
+
+void SwapRouter::refresh() {
+  routerMutex.lock();
+  // Blocks that arrive while a read is in flight are skipped, the next one reads again
+  if (!running || refreshing) { routerMutex.unlock(); return; }
+  refreshing = true;
+  uint64_t gen = generation;
+  bool needPairs = !discovered;
+  std::vector<std::string> tokenList = tokens;
+  routerMutex.unlock();
+
+  if (needPairs) {
+    discover(gen, tokenList);
+  } else {
+    std::shared_ptr<const SwapGraph> current = std::atomic_load(&graph);
+    if (current == nullptr || current->pairs.empty()) { finish(gen); return; }
+    readReserves(gen, current->pairs);
+  }
+}
+
+void SwapRouter::discover(uint64_t gen, std::vector<std::string> tokenList) {
+  // Every token against every base token (and the base tokens among themselves)
+  std::vector<std::string> all = baseTokens;
+  for (std::string &token : tokenList) {
+    std::string t = normalize(token);
+    if (std::find(all.begin(), all.end(), t) == all.end()) { all.push_back(t); }
+  }
+  std::vector<std::pair<std::string, std::string>> candidates;
+  std::vector<MulticallCall> calls;
+  for (size_t i = 0; i < all.size(); i++) {
+    for (size_t j = 0; j < std::min(i, baseTokens.size()); j++) {
+      // Pairs always keep the lower address as token0
+      std::string token0 = std::min(all[i], all[j]);
+      std::string token1 = std::max(all[i], all[j]);
+      candidates.push_back(std::make_pair(token0, token1));
+      calls.push_back(Multicall::makeCall(Pangolin::contracts["factory"],
+        Pangolin::factoryFuncs["getPair"] + Utils::addressToHex(token0) + Utils::addressToHex(token1)
+      ));
+    }
+  }
+
+  std::string reqBody = API::buildMultiRequest(Multicall::buildRequests(calls, 1));
+  API::httpGetRequestAsync(reqBody, [=](std::string resp){
+    std::vector<SwapPair> pairs;
+    try {
+      std::vector<MulticallResult> results = Multicall::parseResponses(calls, json::parse(resp), 1);
+      for (size_t i = 0; i < results.size(); i++) {
+        if (!results[i].success || results[i].returnData.size() < 66) { continue; }
+        std::string pairAddress = "0x" + results[i].returnData.substr(26, 40);
+        if (pairAddress == "0x0000000000000000000000000000000000000000") { continue; }
+        SwapPair pair;
+        pair.address = Utils::toLowerCaseAddress(pairAddress);
+        pair.token0 = candidates[i].first;
+        pair.token1 = candidates[i].second;
+        pair.reserve0 = 0;
+        pair.reserve1 = 0;
+        pairs.push_back(pair);
+      }
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("SwapRouter pairs ERROR: ") + e.what());
+      finish(gen);
+      return;
+    }
+    if (pairs.empty()) { finish(gen); return; }
+    readReserves(gen, pairs);
+  });
+}
+
+void SwapRouter::readReserves(uint64_t gen, std::vector<SwapPair> pairs) {
+  std::vector<MulticallCall> calls;
+  for (SwapPair &pair : pairs) {
+    calls.push_back(Multicall::makeCall(pair.address, Pangolin::pairFuncs["getReserves"]));
+  }
+
+  std::string reqBody = API::buildMultiRequest(Multicall::buildRequests(calls, 1));
+  API::httpGetRequestAsync(reqBody, [=](std::string resp){
+    std::shared_ptr<SwapGraph> newGraph = std::make_shared<SwapGraph>();
+    try {
+      std::vector<MulticallResult> results = Multicall::parseResponses(calls, json::parse(resp), 1);
+      for (size_t i = 0; i < results.size(); i++) {
+        SwapPair pair = pairs[i];
+        // getReserves() returns (uint112 reserve0, uint112 reserve1, uint32 timestamp).
+        // Pairs that failed keep their last known reserves
+        if (results[i].success && results[i].returnData.size() >= 130) {
+          u256 reserve0 = boost::lexical_cast<HexTo<u256>>("0x" + results[i].returnData.substr(2, 64));
+          u256 reserve1 = boost::lexical_cast<HexTo<u256>>("0x" + results[i].returnData.substr(66, 64));
+          pair.reserve0 = reserve0;
+          pair.reserve1 = reserve1;
+        }
+        newGraph->edges[pair.token0].push_back(newGraph->pairs.size());
+        newGraph->edges[pair.token1].push_back(newGraph->pairs.size());
+        newGraph->pairs.push_back(pair);
+      }
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("SwapRouter reserves ERROR: ") + e.what());
+      finish(gen);
+      return;
+    }
+    routerMutex.lock();
+    if (running && gen == generation) {
+      std::atomic_store(&graph, std::shared_ptr<const SwapGraph>(newGraph));
+      discovered = true;
+    }
+    routerMutex.unlock();
+    finish(gen);
+  });
+}
+
+void SwapRouter::finish(uint64_t gen) {
+  routerMutex.lock();
+  refreshing = false;
+  bool again = (running && gen != generation);
+  routerMutex.unlock();
+  if (again) { refresh(); }
+}
+
+void SwapRouter::search(
+  const SwapGraph &g, const std::string &token, const std::string &target,
+  const u256 &amount, bool exactIn, size_t hopsLeft,
+  std::vector<std::string> &path, std::vector<size_t> &usedPairs,
+  SwapQuote &best, bool &found
+) {
+  auto it = g.edges.find(token);
+  if (it == g.edges.end()) { return; }
+  for (size_t pairIdx : it->second) {
+    if (std::find(usedPairs.begin(), usedPairs.end(), pairIdx) != usedPairs.end()) { continue; }
+    const SwapPair &pair = g.pairs[pairIdx];
+    bool isToken0 = (pair.token0 == token);
+    const std::string &other = (isToken0) ? pair.token1 : pair.token0;
+    if (std::find(path.begin(), path.end(), other) != path.end()) { continue; }
+    const u256 &reserveToken = (isToken0) ? pair.reserve0 : pair.reserve1;
+    const u256 &reserveOther = (isToken0) ? pair.reserve1 : pair.reserve0;
+
+    /**
+     * Going forward (exact input), "amount" is what goes into this pair
+     * and the next amount is what comes out of it.
+     * Going backward from the output (exact output), "amount" is what has
+     * to come out of this pair and the next amount is what has to go in.
+     */
+    u256 next = (exactIn)
+      ? Pangolin::calcExchangeAmountOut(amount, reserveToken, reserveOther)
+      : Pangolin::calcExchangeAmountIn(amount, reserveOther, reserveToken);
+    if (next == 0) { continue; }
+
+    path.push_back(other);
+    usedPairs.push_back(pairIdx);
+    if (other == target) {
+      if (exactIn && (!found || next > best.amountOut)) {
+        best.amountOut = next;
+        best.path = path;
+        found = true;
+      } else if (!exactIn && (!found || next < best.amountIn)) {
+        best.amountIn = next;
+        best.path = path;
+        found = true;
+      }
+    } else if (hopsLeft > 1) {
+      search(g, other, target, next, exactIn, hopsLeft - 1, path, usedPairs, best, found);
+    }
+    path.pop_back();
+    usedPairs.pop_back();
+  }
+}
+
+void SwapRouter::start(std::vector<std::string> tokens) {
+  routerMutex.lock();
+  SwapRouter::tokens = tokens;
+  generation++;
+  discovered = false;
+  running = true;
+  watcher.start();
+  routerMutex.unlock();
+  refresh();
+}
+
+void SwapRouter::stop() {
+  routerMutex.lock();
+  running = false;
+  generation++;
+  discovered = false;
+  watcher.stop();
+  routerMutex.unlock();
+  std::atomic_store(&graph, std::shared_ptr<const SwapGraph>());
+}
+
+bool SwapRouter::isReady() {
+  std::shared_ptr<const SwapGraph> current = std::atomic_load(&graph);
+  return (current != nullptr && !current->pairs.empty());
+}
+
+bool SwapRouter::quote(
+  std::string tokenIn, std::string tokenOut, const u256 &amount,
+  bool exactIn, SwapQuote &quote
+) {
+  std::string in = normalize(tokenIn);
+  std::string out = normalize(tokenOut);
+  if (in == out || amount == 0) { return false; }
+  std::shared_ptr<const SwapGraph> current = std::atomic_load(&graph);
+  if (current == nullptr) { return false; }
+
+  // Exact output routes are searched backward, from the output to the input
+  SwapQuote best;
+  bool found = false;
+  std::vector<std::string> path = { (exactIn) ? in : out };
+  std::vector<size_t> usedPairs;
+  search(*current, path[0], (exactIn) ? out : in, amount, exactIn, maxHops, path, usedPairs, best, found);
+  if (!found) { return false; }
+
+  if (exactIn) {
+    best.amountIn = amount;
+  } else {
+    best.amountOut = amount;
+    std::reverse(best.path.begin(), best.path.end());
+  }
+  quote = best;
+  return true;
+}
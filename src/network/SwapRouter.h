@@ -0,0 +1,132 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef SWAPROUTER_H
+#define SWAPROUTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <core/Utils.h>
+#include <network/API.h>
+#include <network/BlockWatcher.h>
+#include <network/Multicall.h>
+#include <network/Pangolin.h>
+
+// A Pangolin pair and its last known reserves. Addresses are lowercase.
+typedef struct SwapPair {
+  std::string address;
+  std::string token0;
+  std::string token1;
+  u256 reserve0;
+  u256 reserve1;
+} SwapPair;
+
+// The pairs known to the router, and which pairs each token is in (by index).
+typedef struct SwapGraph {
+  std::vector<SwapPair> pairs;
+  std::map<std::string, std::vector<size_t>> edges;
+} SwapGraph;
+
+// The best route found for a swap. Path has every token from input to output.
+typedef struct SwapQuote {
+  u256 amountIn;
+  u256 amountOut;
+  std::vector<std::string> path;
+} SwapQuote;
+
+/**
+ * Local swap quotes over Pangolin's pairs, so the exchange screen doesn't
+ * have to ask ParaSwap on every keystroke (ParaSwap is only asked for the
+ * final route and transaction data).
+ * Pairs between the routed tokens and a few base tokens are found once
+ * through the factory, then their reserves are read in one Multicall
+ * eth_call on every new block from BlockWatcher. Quotes walk the graph
+ * for the best path of up to maxHops pairs, all in u256 on the current
+ * graph, which is swapped atomically so reading it never blocks.
+ */
+class SwapRouter {
+  private:
+    // Tokens every routed token is paired against, looking for paths.
+    static std::vector<std::string> baseTokens;
+
+    // Tokens being routed (besides the base ones).
+    static std::vector<std::string> tokens;
+
+    // Current graph. Only replaced whole, with std::atomic_load/atomic_store.
+    static std::shared_ptr<const SwapGraph> graph;
+
+    // BlockWatcher subscription, and whether the router is running.
+    static BlockSubscription watcher;
+    static bool running;
+
+    // Bumped on every start/stop/token change, so old answers are thrown away.
+    static uint64_t generation;
+
+    // Whether pairs were found for the current tokens, and if a read is in flight.
+    static bool discovered;
+    static bool refreshing;
+
+    // Mutex for all the members above, except the graph.
+    static std::mutex routerMutex;
+
+    // Lowercase an address, taking the native coin (ParaSwap's 0xEeee...) as WAVAX.
+    static std::string normalize(std::string token);
+
+    // Called by BlockWatcher for each new block.
+    static void onBlock(uint64_t block);
+
+    // Find the pairs (if not found yet) or read their reserves again.
+    static void refresh();
+
+    // Find the pairs between the tokens and the base tokens through the factory.
+    static void discover(uint64_t gen, std::vector<std::string> tokenList);
+
+    // Read the reserves of the given pairs into a new graph.
+    static void readReserves(uint64_t gen, std::vector<SwapPair> pairs);
+
+    // Finish a refresh, trying again if the tokens changed meanwhile.
+    static void finish(uint64_t gen);
+
+    // Walk the graph from a token, keeping the best amount found at the target.
+    static void search(
+      const SwapGraph &g, const std::string &token, const std::string &target,
+      const u256 &amount, bool exactIn, size_t hopsLeft,
+      std::vector<std::string> &path, std::vector<size_t> &usedPairs,
+      SwapQuote &best, bool &found
+    );
+
+  public:
+    // Max number of pairs a route can go through.
+    static const size_t maxHops = 3;
+
+    /**
+     * Start routing between the given tokens (and the base ones), or change
+     * the tokens if already running. Quotes are available once the first
+     * reserves arrive.
+     */
+    static void start(std::vector<std::string> tokens);
+
+    // Stop reading reserves. The last graph is dropped.
+    static void stop();
+
+    // Check if there's a graph to quote from.
+    static bool isReady();
+
+    /**
+     * Find the best route for a swap. exactIn = true gives the most output
+     * for amount as input, false gives the least input for amount as output.
+     * Returns false if there's no route (e.g. no pairs, or not enough liquidity).
+     */
+    static bool quote(
+      std::string tokenIn, std::string tokenOut, const u256 &amount,
+      bool exactIn, SwapQuote &quote
+    );
+};
+
+#endif  // SWAPROUTER_H
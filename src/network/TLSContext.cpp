@@ -0,0 +1,63 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "TLSContext.h"
+
+std::once_flag TLSContext::initFlag;
+std::unique_ptr<boost::asio::ssl::context> TLSContext::ctx;
+std::map<std::string, SSL_SESSION*> TLSContext::sessions;
+std::mutex TLSContext::sessionMutex;
+std::atomic<bool> TLSContext::resumption(true);
+
+void TLSContext::init() {
+  namespace ssl = boost::asio::ssl;       // from <boost/asio/ssl.hpp>
+  ctx.reset(new ssl::context{ssl::context::sslv23_client});
+  load_root_certificates(*ctx);
+
+  // Sessions are stored by us (per host), not by OpenSSL's internal cache
+  SSL_CTX_set_session_cache_mode(
+    ctx->native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE
+  );
+  SSL_CTX_sess_set_new_cb(ctx->native_handle(), &TLSContext::onNewSession);
+}
+
+int TLSContext::onNewSession(SSL* ssl, SSL_SESSION* session) {
+  if (!resumption) { return 0; }
+  const char* name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+  if (name == nullptr) { return 0; }
+  sessionMutex.lock();
+  auto it = sessions.find(name);
+  if (it != sessions.end()) { SSL_SESSION_free(it->second); }
+  sessions[name] = session;
+  sessionMutex.unlock();
+  return 1;
+}
+
+boost::asio::ssl::context& TLSContext::get() {
+  std::call_once(initFlag, &TLSContext::init);
+  return *ctx;
+}
+
+void TLSContext::prepare(SSL* ssl, std::string host) {
+  if (!SSL_set_tlsext_host_name(ssl, host.c_str())) {
+    boost::system::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
+    throw boost::system::system_error{ec};
+  }
+  if (!resumption) { return; }
+  sessionMutex.lock();
+  auto it = sessions.find(host);
+  if (it != sessions.end()) { SSL_set_session(ssl, it->second); }
+  sessionMutex.unlock();
+}
+
+void TLSContext::setSessionResumption(bool enabled) {
+  resumption = enabled;
+  if (!enabled) { clearSessions(); }
+}
+
+void TLSContext::clearSessions() {
+  sessionMutex.lock();
+  for (auto &s : sessions) { SSL_SESSION_free(s.second); }
+  sessions.clear();
+  sessionMutex.unlock();
+}
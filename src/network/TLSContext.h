@@ -0,0 +1,64 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef TLSCONTEXT_H
+#define TLSCONTEXT_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include <network/root_certificates.hpp>
+
+/**
+ * Process-wide TLS client context shared by every HTTPS client in the wallet.
+ * The context (and the parsed root certificate store) is built once, on first
+ * use, instead of once per request.
+ * Optionally keeps the last TLS session (or session ticket) handed out by each
+ * host, so new connections to it can do an abbreviated handshake.
+ */
+class TLSContext {
+  private:
+    static std::once_flag initFlag;
+    static std::unique_ptr<boost::asio::ssl::context> ctx;
+
+    // Last session received from each host (by SNI name), and whether to use them.
+    static std::map<std::string, SSL_SESSION*> sessions;
+    static std::mutex sessionMutex;
+    static std::atomic<bool> resumption;
+
+    // Build the context and load the root certificates into it.
+    static void init();
+
+    /**
+     * OpenSSL callback, called whenever a server hands out a new session.
+     * With TLS 1.3 this happens after the handshake, when the ticket arrives.
+     * Returns 1 when the session was kept (we then own its reference).
+     */
+    static int onNewSession(SSL* ssl, SSL_SESSION* session);
+
+  public:
+    // Get the shared context, building it on the first call. Thread-safe.
+    static boost::asio::ssl::context& get();
+
+    /**
+     * Prepare a stream's native handle for connecting to the given host:
+     * set the SNI hostname (many hosts need this to handshake successfully)
+     * and, if enabled, offer the last known session for resumption.
+     * Throws on failure, same as Beast calls.
+     */
+    static void prepare(SSL* ssl, std::string host);
+
+    // Enable or disable TLS session resumption. Disabling it clears the stored sessions.
+    static void setSessionResumption(bool enabled);
+
+    // Free all stored sessions.
+    static void clearSessions();
+};
+
+#endif  // TLSCONTEXT_H
@@ -0,0 +1,143 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include "TxTracker.h"
+
+std::map<std::string, std::vector<TxTracker::Waiter>> TxTracker::pending;
+BlockSubscription TxTracker::watcher(&TxTracker::onBlock);
+std::unique_ptr<boost::asio::steady_timer> TxTracker::sweepTimer;
+bool TxTracker::sweepArmed = false;
+std::mutex TxTracker::trackMutex;
+
+void TxTracker::track(
+  std::string txHash, TxTrackHandler handler, std::chrono::seconds timeout, const void* owner
+) {
+  boost::algorithm::to_lower(txHash);
+  if (txHash.rfind("0x", 0) != 0) { txHash = "0x" + txHash; }
+  Waiter waiter{handler, std::chrono::steady_clock::now() + timeout, owner};
+  trackMutex.lock();
+  pending[txHash].push_back(waiter);
+  watcher.start();
+  armSweep();
+  trackMutex.unlock();
+}
+
+void TxTracker::cancel(const void* owner) {
+  // Handlers are destroyed outside the lock
+  std::vector<Waiter> dropped;
+  trackMutex.lock();
+  for (auto it = pending.begin(); it != pending.end();) {
+    std::vector<Waiter> &waiters = it->second;
+    for (auto w = waiters.begin(); w != waiters.end();) {
+      if (w->owner == owner) {
+        dropped.push_back(std::move(*w));
+        w = waiters.erase(w);
+      } else {
+        w++;
+      }
+    }
+    it = (waiters.empty()) ? pending.erase(it) : std::next(it);
+  }
+  trackMutex.unlock();
+}
+
+void TxTracker::armSweep() {
+  // Caller must hold trackMutex
+  if (sweepArmed) { return; }
+  if (sweepTimer == nullptr) {
+    sweepTimer.reset(new boost::asio::steady_timer(AsyncClient::getContext()));
+  }
+  sweepArmed = true;
+  sweepTimer->expires_after(std::chrono::seconds(1));
+  sweepTimer->async_wait([](boost::system::error_code ec){
+    if (ec != boost::asio::error::operation_aborted) { sweep(); }
+  });
+}
+
+void TxTracker::sweep() {
+  std::vector<std::pair<Waiter, std::pair<TxTrackStatus, json>>> done;
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  trackMutex.lock();
+  sweepArmed = false;
+  for (auto it = pending.begin(); it != pending.end();) {
+    std::vector<Waiter> &waiters = it->second;
+    for (auto w = waiters.begin(); w != waiters.end();) {
+      if (now >= w->deadline) {
+        done.push_back({*w, {TX_TIMEOUT, json()}});
+        w = waiters.erase(w);
+      } else {
+        w++;
+      }
+    }
+    it = (waiters.empty()) ? pending.erase(it) : std::next(it);
+  }
+  if (!pending.empty()) { armSweep(); }
+  trackMutex.unlock();
+  finish(done);
+}
+
+void TxTracker::finish(std::vector<std::pair<Waiter, std::pair<TxTrackStatus, json>>> &done) {
+  for (auto &d : done) {
+    try {
+      d.first.handler(d.second.first, d.second.second);
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("TxTracker handler ERROR: ") + e.what());
+    }
+  }
+}
+
+size_t TxTracker::getPendingCount() {
+  trackMutex.lock();
+  size_t ret = pending.size();
+  trackMutex.unlock();
+  return ret;
+}
+
+void TxTracker::onBlock(uint64_t block) {
+  std::vector<std::string> hashes;
+  std::vector<Request> reqs;
+  trackMutex.lock();
+  for (std::pair<const std::string, std::vector<Waiter>> &p : pending) {
+    hashes.push_back(p.first);
+    reqs.push_back({hashes.size(), "2.0", "eth_getTransactionReceipt", {p.first}});
+  }
+  // Nothing left to track, stop watching blocks
+  if (hashes.empty()) { watcher.stop(); }
+  trackMutex.unlock();
+  if (hashes.empty()) { return; }
+  API::httpGetRequestAsync(API::buildMultiRequest(reqs), [hashes](std::string resp){
+    onReceipts(hashes, resp);
+  });
+}
+
+void TxTracker::onReceipts(std::vector<std::string> hashes, std::string resp) {
+  // Map each receipt to its hash by id. Failed requests are just tried again next block.
+  std::map<std::string, json> receipts;
+  try {
+    json respJson = json::parse(resp);
+    if (!respJson.is_array()) { respJson = json::array({respJson}); }
+    for (json &item : respJson) {
+      if (!item.contains("id") || !item["id"].is_number_unsigned()) { continue; }
+      uint64_t id = item["id"].get<uint64_t>();
+      if (id < 1 || id > hashes.size()) { continue; }
+      if (item.contains("result") && item["result"].is_object()) {
+        receipts[hashes[id - 1]] = item["result"];
+      }
+    }
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("TxTracker ERROR: ") + e.what());
+  }
+
+  // Take everyone who's done out of the list first, so no handler is called twice
+  std::vector<std::pair<Waiter, std::pair<TxTrackStatus, json>>> done;
+  trackMutex.lock();
+  for (std::pair<const std::string, json> &receipt : receipts) {
+    auto it = pending.find(receipt.first);
+    if (it == pending.end()) { continue; }
+    TxTrackStatus status = (receipt.second.value("status", "") == "0x0") ? TX_FAILED : TX_CONFIRMED;
+    for (Waiter &w : it->second) { done.push_back({w, {status, receipt.second}}); }
+    pending.erase(it);
+  }
+  trackMutex.unlock();
+  finish(done);
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2020-2021 AVME Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#ifndef TXTRACKER_H
+#define TXTRACKER_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include <network/API.h>
+#include <network/BlockWatcher.h>
+
+// Final state of a tracked transaction.
+enum TxTrackStatus { TX_CONFIRMED, TX_FAILED, TX_TIMEOUT };
+
+// Callback for tracked transactions. Receives the final state and the
+// transaction's receipt (null on timeout).
+typedef std::function<void(TxTrackStatus, json)> TxTrackHandler;
+
+/**
+ * Shared confirmation tracker for sent transactions.
+ * Instead of polling each transaction on its own, it waits for new blocks
+ * from BlockWatcher and asks for the receipts of all pending transactions
+ * in one JSON-RPC batch per block.
+ * Each handler is called once, from a network thread, when its transaction
+ * is mined (TX_CONFIRMED, or TX_FAILED if it reverted) or when its timeout
+ * runs out (TX_TIMEOUT). Handlers must not block on network calls.
+ */
+class TxTracker {
+  private:
+    // A handler waiting for a transaction, and when it gives up.
+    typedef struct Waiter {
+      TxTrackHandler handler;
+      std::chrono::steady_clock::time_point deadline;
+      const void* owner;
+    } Waiter;
+
+    // Waiters for each pending transaction hash (lowercase, with "0x").
+    static std::map<std::string, std::vector<Waiter>> pending;
+
+    // BlockWatcher subscription, active while there's something to track.
+    static BlockSubscription watcher;
+
+    // Timer for timing out waiters even if no new blocks arrive.
+    static std::unique_ptr<boost::asio::steady_timer> sweepTimer;
+    static bool sweepArmed;
+
+    // Mutex for all the members above.
+    static std::mutex trackMutex;
+
+    // Ask for the receipts of all pending transactions.
+    static void onBlock(uint64_t block);
+
+    // Handle the receipts answer.
+    static void onReceipts(std::vector<std::string> hashes, std::string resp);
+
+    // Time out anyone left waiting for too long, every second while needed.
+    static void sweep();
+    static void armSweep();
+
+    // Call the handlers of finished waiters (outside the lock).
+    static void finish(std::vector<std::pair<Waiter, std::pair<TxTrackStatus, json>>> &done);
+
+  public:
+    /**
+     * Track a transaction until it's mined or the timeout runs out.
+     * The same transaction can be tracked by several handlers at once.
+     * owner is optional, and lets cancel() drop the handlers later.
+     */
+    static void track(
+      std::string txHash, TxTrackHandler handler,
+      std::chrono::seconds timeout = std::chrono::seconds(15),
+      const void* owner = nullptr
+    );
+
+    /**
+     * Drop every handler of an owner without calling it. A handler that's
+     * already running isn't waited for, owners must guard against that.
+     */
+    static void cancel(const void* owner);
+
+    // Get the number of transactions being tracked.
+    static size_t getPendingCount();
+};
+
+#endif  // TXTRACKER_H
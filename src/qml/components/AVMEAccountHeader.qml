@@ -31,7 +31,6 @@ Rectangle {
 
   signal updatedBalances()
 
-  Timer { id: balancesTimer; interval: 1000; repeat: true; onTriggered: refreshBalances() }
   // TODO: Remove all "useless" ledger calls
   Timer { id: ledgerRetryTimer; interval: 250; onTriggered: checkLedger() }
 
@@ -68,6 +67,38 @@ Rectangle {
         updatedBalances()
       }
     }
+    function onAccountBalancesChanged(address, tokenJsonListStr, coinInformationJsonStr, gasPriceStr, full) {
+      // Only what changed is sent, so merge it with what's already known
+      if (address != currentAddress) { return }
+      if (coinInformationJsonStr != "") {
+        var coinInformation = JSON.parse(coinInformationJsonStr)
+        coinRawBalance = coinInformation["coinBalance"]
+        coinFiatValue = coinInformation["coinFiatBalance"]
+        coinUSDPrice = coinInformation["coinFiatPrice"]
+        coinUSDPriceChart = coinInformation["coinPriceChart"]
+      }
+      var newTokenList = (full) ? ({}) : Object.assign({}, tokenList)
+      var tokenJsonList = JSON.parse(tokenJsonListStr)
+      for (var i = 0; i < tokenJsonList.length; ++i) {
+        var tokenInformation = ({})
+        tokenInformation["rawBalance"] = tokenJsonList[i]["tokenRawBalance"]
+        tokenInformation["fiatValue"] = +tokenJsonList[i]["tokenFiatValue"]
+        tokenInformation["fiatValue"] = tokenInformation["fiatValue"].toFixed(2)
+        tokenInformation["derivedValue"] = tokenJsonList[i]["tokenDerivedValue"]
+        tokenInformation["symbol"] = tokenJsonList[i]["tokenSymbol"]
+        tokenInformation["chartData"] = tokenJsonList[i]["tokenChartData"]
+        tokenInformation["USDprice"] = tokenJsonList[i]["tokenUSDPrice"]
+        tokenInformation["decimals"] = tokenJsonList[i]["tokenDecimals"]
+        tokenInformation["name"] = tokenJsonList[i]["tokenName"]
+        newTokenList[tokenJsonList[i]["tokenAddress"]] = tokenInformation
+      }
+      tokenList = newTokenList
+      var total = +coinFiatValue
+      for (var token in tokenList) { total += +tokenList[token]["fiatValue"] }
+      totalFiatBalance = (Math.round(total * 100) / 100).toFixed(2) // Use only two digits precision for fiat
+      if (gasPriceStr != "") { gasPrice = String(Math.round(+gasPriceStr)) }
+      updatedBalances()
+    }
     function onAskForPermission(website_) {
       website = website_
       confirmWebsiteAllowance.open()
@@ -101,8 +132,8 @@ Rectangle {
 
   function getAddress() {
     currentAddress = qmlSystem.getCurrentAccount()
-    refreshBalances()
-    balancesTimer.start()
+    // Balances are pushed once per new block, and only when they change
+    qmlSystem.startPortfolio(currentAddress)
   }
 
   function refreshBalances() {
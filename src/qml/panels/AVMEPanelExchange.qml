@@ -373,9 +373,11 @@ AVMEPanel {
     // as a string. For that reason there's an updateDisplay() function which
     // will provide these variables with the new information from "exchangeInfo"
     balanceTimer.start()
+    qmlSystem.startSwapRouter()
     updateDisplay()
     fetchAllowance(true)
   }
+  Component.onDestruction: qmlSystem.stopSwapRouter()
 
   function fetchAllowance(updateAssets) {
     if (updateAssets) {
@@ -484,12 +486,30 @@ AVMEPanel {
     updateDisplay()
   }
 
+  // Show a local estimate (Pangolin only) while ParaSwap works out the final route
+  function quoteLocally(side) {
+    var fromInput = (side == "SELL") ? leftInput : rightInput
+    var toInput = (side == "SELL") ? rightInput : leftInput
+    var fromDecimals = (side == "SELL") ? exchangeInfo["left"]["decimals"] : exchangeInfo["right"]["decimals"]
+    var toDecimals = (side == "SELL") ? exchangeInfo["right"]["decimals"] : exchangeInfo["left"]["decimals"]
+    toInput.text = ""
+    toInput.placeholder = "Amount (e.g. 0.5)"
+    if (!fromInput.acceptableInput || +fromInput.text == 0) { return false }
+    var quote = qmlSystem.quoteSwap(exchangeInfo["left"]["contract"],
+                                    exchangeInfo["right"]["contract"],
+                                    qmlApi.fixedPointToWei(fromInput.text, fromDecimals),
+                                    side)
+    if (!quote["amount"]) { return false }
+    toInput.placeholder = "~" + qmlApi.weiToFixedPoint(quote["amount"], toDecimals)
+    return true
+  }
+
   function getPriceOnEditLeft() {
     randomID = qmlApi.getRandomID()
     loading = true
     rightInput.enabled = false
     rightInput.text = ""
-    rightInput.placeholder = "Loading..."
+    if (!quoteLocally("SELL")) { rightInput.placeholder = "Loading..." }
 
     qmlSystem.getParaSwapTokenPrices(exchangeInfo["left"]["contract"],
                                      exchangeInfo["left"]["decimals"],
@@ -507,7 +527,7 @@ AVMEPanel {
     loading = true
     leftInput.enabled = false
     leftInput.text = ""
-    leftInput.placeholder = "Loading..."
+    if (!quoteLocally("BUY")) { leftInput.placeholder = "Loading..." }
 
     qmlSystem.getParaSwapTokenPrices(exchangeInfo["left"]["contract"],
                                      exchangeInfo["left"]["decimals"],
@@ -795,6 +815,7 @@ AVMEPanel {
       onTextEdited: {
         transactionReady = false
         reachedPriceImpact = false
+        quoteLocally("SELL")
         getPriceOnEditLeftTimer.stop()
         getPriceOnEditLeftTimer.start()
       }
@@ -832,6 +853,7 @@ AVMEPanel {
       onTextEdited: {
         transactionReady = false
         reachedPriceImpact = false
+        quoteLocally("BUY")
         getPriceOnEditRightTimer.stop()
         getPriceOnEditRightTimer.start()
       }
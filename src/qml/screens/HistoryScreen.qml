@@ -10,20 +10,25 @@ import "qrc:/qml/popups"
 // Screen for showing the transaction history for the Account
 Item {
   id: historyScreen
-  property bool sortByNew: true
+  property string nextCursor: ""
+  property bool hasMore: false
+  property bool loadingPage: false
+  property int pageSize: 50
 
   Connections {
     target: qmlSystem
-    function onHistoryLoaded(dataStr) {
-      historyModel.clear()
+    function onHistoryLoaded(dataStr, cursor, more, isNextPage) {
+      if (!isNextPage) { historyModel.clear() }
       if (dataStr != null) {
         var data = JSON.parse(dataStr)
         for (var i = 0; i < data.length; i++) {
           historyModel.append(data[i])
         }
-        historyModel.sortByTimestamp()
-        historyList.currentIndex = 0
+        if (!isNextPage) { historyList.currentIndex = 0 }
       }
+      nextCursor = cursor
+      hasMore = more
+      loadingPage = false
       if (historyModel.count > 0) {
         infoText.text = ""
         infoText.visible = false
@@ -32,15 +37,29 @@ Item {
         infoText.visible = true
       }
     }
+    function onPendingTxStatusesRefreshed(updated) {
+      if (updated > 0) { reloadTransactions() }
+    }
   }
 
-  Component.onCompleted: reloadTransactions()
+  Component.onCompleted: {
+    reloadTransactions()
+    qmlSystem.refreshPendingTxStatuses()
+  }
 
+  // Pages come newest first, so they're appended as the list scrolls down
   function reloadTransactions() {
     historyModel.clear()
     infoText.text = "Loading transactions..."
     infoText.visible = true
-    qmlSystem.listAccountTransactions(qmlSystem.getCurrentAccount())
+    loadingPage = true
+    qmlSystem.listAccountTransactions("", pageSize)
+  }
+
+  function loadNextPage() {
+    if (!hasMore || loadingPage) { return }
+    loadingPage = true
+    qmlSystem.listAccountTransactions(nextCursor, pageSize)
   }
 
   AVMEButton {
@@ -72,16 +91,8 @@ Item {
     AVMETxHistoryList {
       id: historyList
       anchors.fill: parent
-      model: ListModel {
-        id: historyModel
-        function sortByTimestamp() {
-          for (var i = 0; i < count; i++) {
-            for (var j = 0; j < i; j++) {
-              if (get(i).unixtime > get(j).unixtime) { move(i, j, 1) }
-            }
-          }
-        }
-      }
+      model: ListModel { id: historyModel }
+      onAtYEndChanged: if (atYEnd) { historyScreen.loadNextPage() }
     }
   }
 
@@ -137,7 +148,7 @@ Item {
         text: "Refresh Transaction Status"
         onClicked: {
           qmlSystem.updateTxStatus(historyList.currentItem.itemHash)
-          qmlSystem.listAccountTransactions(qmlSystem.getCurrentAccount())
+          reloadTransactions()
         }
       }
 
@@ -171,7 +182,7 @@ Item {
     yesBtn.onClicked: {
       qmlSystem.eraseAllHistory()
       eraseHistoryPopup.close()
-      qmlSystem.listAccountTransactions(qmlSystem.getCurrentAccount())
+      reloadTransactions()
     }
     noBtn.onClicked: eraseHistoryPopup.close()
   }
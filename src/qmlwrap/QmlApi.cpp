@@ -5,20 +5,19 @@
 #include "QmlApi.h"
 
 void QmlApi::doAPIRequests(QString requestID) {
-  QtConcurrent::run([=](){
-    std::string requests;
-    try {
-      requestListLock.lock();
-      requests = API::buildMultiRequest(this->requestList[requestID]);
-    } catch (std::exception &e) {
-      requestListLock.unlock();
-      emit apiRequestAnswered(QString::fromStdString(std::string("{ \"ERROR\": \"") + e.what() + "\"}"), requestID);
-      return;
-    }
-    this->requestList[requestID].clear();
-    this->requestList.erase(requestID);
+  std::string requests;
+  try {
+    requestListLock.lock();
+    requests = API::buildMultiRequest(this->requestList[requestID]);
+  } catch (std::exception &e) {
     requestListLock.unlock();
-    std::string response = API::httpGetRequest(requests);
+    emit apiRequestAnswered(QString::fromStdString(std::string("{ \"ERROR\": \"") + e.what() + "\"}"), requestID);
+    return;
+  }
+  this->requestList[requestID].clear();
+  this->requestList.erase(requestID);
+  requestListLock.unlock();
+  API::httpGetRequestAsync(requests, [=](std::string response){
     emit apiRequestAnswered(QString::fromStdString(response), requestID);
   });
 }
@@ -240,7 +239,7 @@ QString QmlApi::getFirstFromPair(QString assetAddressA, QString assetAddressB) {
 
 void QmlApi::getTokenPriceHistory(QString address, int days, QString requestID) {
   QtConcurrent::run([=](){
-    emit tokenPriceHistoryAnswered(QString::fromStdString(Graph::getTokenPriceHistory(address.toStdString(), days).dump()), requestID, days);
+    emit tokenPriceHistoryAnswered(QString::fromStdString(PriceStore::getTokenPriceHistory(address.toStdString(), days).dump()), requestID, days);
   });
 }
 
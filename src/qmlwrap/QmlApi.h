@@ -16,6 +16,7 @@
 
 #include <network/API.h>
 #include <network/Graph.h>
+#include <network/PriceStore.h>
 #include <core/BIP39.h>
 #include <core/ABI.h>
 #include <core/Utils.h>
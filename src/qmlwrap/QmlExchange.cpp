@@ -11,6 +11,7 @@ QString QmlSystem::calculateExchangeAmount(
   std::string amountOut = Pangolin::calcExchangeAmountOut(
     amountInWei, reservesIn.toStdString(), reservesOut.toStdString()
   );
+  if (amountOut.empty()) { return ""; }  // No quote
   amountOut = Utils::weiToFixedPoint(amountOut, outDecimals);
   return QString::fromStdString(amountOut);
 }
@@ -136,6 +137,38 @@ QVariantMap QmlSystem::calculatePoolSharesForTokenValue(
 }
 
 
+void QmlSystem::startSwapRouter() {
+  std::vector<std::string> tokenList;
+  for (ARC20Token &token : QmlSystem::w.getARC20Tokens()) { tokenList.push_back(token.address); }
+  SwapRouter::start(tokenList);
+}
+
+void QmlSystem::stopSwapRouter() { SwapRouter::stop(); }
+
+QVariantMap QmlSystem::quoteSwap(
+  QString srcToken, QString destToken, QString weiAmount, QString side
+) {
+  QVariantMap ret;
+  SwapQuote quote;
+  try {
+    u256 amount = boost::lexical_cast<u256>(weiAmount.toStdString());
+    bool exactIn = (side != "BUY");
+    if (!SwapRouter::quote(srcToken.toStdString(), destToken.toStdString(), amount, exactIn, quote)) {
+      return ret;
+    }
+    ret["amount"] = QString::fromStdString(boost::lexical_cast<std::string>(
+      (exactIn) ? quote.amountOut : quote.amountIn
+    ));
+  } catch (std::exception &e) {
+    Utils::logToDebug(std::string("quoteSwap ERROR: ") + e.what());
+    return ret;
+  }
+  QStringList path;
+  for (std::string &token : quote.path) { path << QString::fromStdString(token); }
+  ret["path"] = path;
+  return ret;
+}
+
 void  QmlSystem::getParaSwapTokenPrices(QString srcToken, 
                              QString srcDecimals, 
                              QString destToken,
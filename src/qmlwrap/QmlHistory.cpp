@@ -4,12 +4,16 @@
 
 #include <qmlwrap/QmlSystem.h>
 
-void QmlSystem::listAccountTransactions(QString address) {
+void QmlSystem::listAccountTransactions(QString cursor, int limit, QString operation) {
   QtConcurrent::run([=](){
     json ret = json::array();
-    this->w.loadTxHistory();
+    TxHistoryFilter filter;
+    filter.operation = operation.toStdString();
+    TxHistoryPage page = this->w.loadTxHistoryPage(
+      dev::asString(dev::fromHex(cursor.toStdString())), (limit > 0) ? limit : 0, filter
+    );
 
-    for (TxData tx : this->w.getCurrentAccountHistory()) {
+    for (TxData tx : page.txs) {
       json obj;
       obj["operation"] = tx.operation;
       obj["hex"] = tx.hex;
@@ -26,7 +30,11 @@ void QmlSystem::listAccountTransactions(QString address) {
       obj["invalid"] = tx.invalid;
       ret.push_back(obj);
     }
-    emit historyLoaded(QString::fromStdString(ret.dump()));
+    emit historyLoaded(
+      QString::fromStdString(ret.dump()),
+      QString::fromStdString(dev::toHex(page.nextCursor)),
+      page.hasMore, !cursor.isEmpty()
+    );
   });
 }
 
@@ -34,6 +42,12 @@ void QmlSystem::updateTxStatus(QString txHash) {
   this->w.updateTxStatus(txHash.toStdString());
 }
 
+void QmlSystem::refreshPendingTxStatuses() {
+  QtConcurrent::run([=](){
+    emit pendingTxStatusesRefreshed(int(this->w.refreshPendingTxStatuses()));
+  });
+}
+
 void QmlSystem::eraseAllHistory() {
   this->w.eraseAllHistory();
 }
@@ -67,10 +67,11 @@ bool QmlSystem::hasInsufficientFunds(
 }
 
 void QmlSystem::updateAccountNonce(QString from) {
-  QtConcurrent::run([=](){
+  Request req{1, "2.0", "eth_getTransactionCount", {from.toStdString(), "latest"}};
+  API::httpGetRequestAsync(API::buildRequest(req), [=](std::string resp){
     std::string ret;
-    std::string nonce = API::getNonce(from.toStdString());
-    auto nonceParsed = Pangolin::parseHex(nonce, {"uint"});
+    json respJson = json::parse(resp);
+    auto nonceParsed = Pangolin::parseHex(respJson["result"].get<std::string>(), {"uint"});
     ret = nonceParsed[0];
     emit this->accountNonceUpdate(QString::fromStdString(ret));
   });
@@ -142,34 +143,58 @@ void QmlSystem::makeTransaction(
   });
 }
 
-void QmlSystem::checkTransactionFor15s(QString txid, QString randomID) {
+void QmlSystem::makeTransactionBatch(
+  QString operation, QString from, QVariantList txs,
+  QString gasPrice, QString pass, QString randomID
+) {
   QtConcurrent::run([=](){
-    // Request current block and current transaction status for around 15 seconds
-    auto t_start = std::chrono::high_resolution_clock::now();
-    // Build the request data outside of the loop to avoid unecessary computing
-    Request transactionReceipt({1, "2.0", "eth_getTransactionReceipt", {txid.toStdString()}});
-    while (true) { // Use "break" to exit the function
-      auto t_end = std::chrono::high_resolution_clock::now();
-      double elapsed_time_ms = std::chrono::duration<double, std::milli>(t_end-t_start).count();
-      if (elapsed_time_ms > 15000) {
-        emit txConfirmed(false, txid, randomID);
-        break;
-      }
-
-      json result = json::parse(API::httpGetRequest(API::buildRequest(transactionReceipt)));
-      //std::cout << result.dump(2) << std::endl;
-      std::string status = "";
-
-      // Check if transaction was included in a block, a.k.a confirmed
-      if (result.contains("result")) {
-        if (result["result"].contains("status")) {
-          status = result["result"]["status"];
-        }
-      }
-      if (status != "") {
-        emit txConfirmed(true, txid, randomID);
-        break;
+    // Every transaction gets the same error if the batch can't be sent at all
+    auto fail = [&](std::string msg){
+      json err;
+      err["jsonrpc"] = "2.0";
+      err["error"]["code"] = -32603;
+      err["error"]["message"] = msg;
+      json ret = json::array();
+      for (int i = 0; i < txs.size(); i++) { ret.push_back(err); }
+      emit txBatchSent(QString::fromStdString(ret.dump()), randomID);
+    };
+    // Batches are signed in one go with the Account's key, which a Ledger
+    // can't do (every transaction would need its own confirmation)
+    if (QmlSystem::getLedgerFlag()) {
+      fail("Transaction batches are not supported on Ledger Accounts");
+      return;
+    }
+    try {
+      // Gas price is in Gwei (10^9 Wei), amounts are in fixed point
+      std::string gasPriceStr = boost::lexical_cast<std::string>(
+        boost::lexical_cast<u256>(gasPrice.toStdString()) * raiseToPow(10, 9)
+      );
+      std::vector<TransactionSkeleton> txSkels;
+      std::vector<std::string> operations;
+      for (QVariant tx : txs) {
+        QVariantMap txMap = tx.toMap();
+        txSkels.push_back(this->w.buildTransaction(
+          from.toStdString(), txMap["to"].toString().toStdString(),
+          Utils::fixedPointToWei(txMap["value"].toString().toStdString(), 18),
+          txMap["gas"].toString().toStdString(), gasPriceStr,
+          txMap["txData"].toString().toStdString(), "0"
+        ));
+        operations.push_back(operation.toStdString());
       }
+      std::vector<json> results = this->w.sendTransactionBatch(txSkels, operations, pass.toStdString());
+      json ret = json::array();
+      for (json &result : results) { ret.push_back(result); }
+      emit txBatchSent(QString::fromStdString(ret.dump()), randomID);
+    } catch (std::exception &e) {
+      Utils::logToDebug(std::string("makeTransactionBatch ERROR: ") + e.what());
+      fail(std::string("Error on sending transaction batch: ") + e.what());
     }
   });
 }
+
+void QmlSystem::checkTransactionFor15s(QString txid, QString randomID) {
+  // A mined tx counts as confirmed even if it reverted, same as before
+  TxTracker::track(txid.toStdString(), [=](TxTrackStatus status, json receipt){
+    emit txConfirmed(status != TX_TIMEOUT, txid, randomID);
+  }, std::chrono::seconds(15));
+}
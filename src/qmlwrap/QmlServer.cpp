@@ -5,119 +5,108 @@
 #include <qmlwrap/QmlSystem.h>
 #include <network/Server.h> // https://stackoverflow.com/a/4964508
 
-void QmlSystem::handleServer(std::string inputStr, std::shared_ptr<session> session_) {
-  // Run answer in another thread to allow the Server to take more inputs
+std::string QmlSystem::handleServer(std::string inputStr, std::shared_ptr<session> session_) {
   //std::cout << "Server Handler request!" << std::endl;
   //std::cout << inputStr << std::endl;
-  QtConcurrent::run([=](){
-    json request = json::parse(inputStr);
-    json response;
-    // Some requests does not require permission from the user.
-    // For security reasons, we lock out the possibility for the website
-    // To get the user address until he approves it
-    // Besides that, basic requests such as "eth_chainId"
-    // DOES NOT contain "__frameOrigin" to define which website it came from.
-    bool requirePermission = false;
-    bool requestTransaction = false; // Reason inside "eth_sendTransaction" if
-    // Initialize response with common information.
-    response["jsonrpc"] = "2.0";
-    response["id"] = request["id"];
-    if (request["method"] == "eth_chainId") {
-      response["result"] = "0xa86a";
-      requirePermission = false;
-    } else if (request["method"] == "net_version") {
-      response["result"] = "43114";
-      requirePermission = false;
-    } else if(request["method"] == "eth_requestAccounts" || request["method"] == "eth_accounts") {
-      response["result"] = json::array();
-      response["result"].push_back(this->getCurrentAccount().toStdString());
-    requirePermission = true;
-    } else if(request["method"] == "eth_subscribe") {
-      response["error"]["code"] = -32601;
-      response["error"]["message"] = "Method not found";
-      requirePermission = false;
-    } else if (request["method"] == "eth_sendTransaction") {
-      // We cannot request the transaction here, we need to wait until it checks
-      // Against websites permissions.
-      // It is a mess, I do agree with you, but it is effective
-      requestTransaction = true;
-      requirePermission = true;
+  json request;
+  json response;
+  response["jsonrpc"] = "2.0";
+  try {
+    request = json::parse(inputStr);
+  } catch (std::exception &e) {
+    response["id"] = nullptr;
+    response["error"]["code"] = -32700;
+    response["error"]["message"] = "Parse error";
+    session_->do_write(response.dump());
+    return "invalid";
+  }
+  if (!request.is_object() || !request.contains("method") || !request["method"].is_string()) {
+    response["id"] = nullptr;
+    response["error"]["code"] = -32600;
+    response["error"]["message"] = "Invalid Request";
+    session_->do_write(response.dump());
+    return "invalid";
+  }
+  response["id"] = request["id"];
+  std::string method = request["method"].get<std::string>();
+
+  // Basic requests are answered right away, and anything that is not handled
+  // by the wallet is routed to the avalanche PUBLIC API asynchronously
+  // (batched with other calls made around the same time),
+  // so the Server can take more inputs while the answer is on its way.
+  if (request["method"] == "eth_chainId") {
+    response["result"] = "0xa86a";
+    session_->do_write(response.dump());
+    return method;
+  } else if (request["method"] == "net_version") {
+    response["result"] = "43114";
+    session_->do_write(response.dump());
+    return method;
+  } else if (request["method"] == "eth_subscribe") {
+    // All sessions share the same upstream, notifications are pushed through the session
+    json params = (request.contains("params")) ? request["params"] : json::array();
+    std::string type = (params.is_array() && params.size() > 0 && params[0].is_string())
+      ? params[0].get<std::string>() : "";
+    json filter = (params.is_array() && params.size() > 1) ? params[1] : json();
+    std::weak_ptr<session> weakSession = session_;
+    std::string id = SubscriptionHub::subscribe(type, filter, session_.get(), [weakSession](std::string msg){
+      std::shared_ptr<session> s = weakSession.lock();
+      if (s) { s->do_write(msg); }
+    });
+    if (id.empty()) {
+      response["error"]["code"] = -32602;
+      response["error"]["message"] = "Unsupported subscription type";
     } else {
-      // Route any future request to the avalanche PUBLIC API.
-      response = json::parse(API::httpGetRequest(request.dump(), true));
-      requirePermission = false;
-    }
-    if (request["method"] != "eth_call" &&
-        request["method"] != "eth_chainId" &&
-        request["method"] != "eth_estimateGas" &&
-        request["method"] != "net_version" &&
-        request["method"] != "eth_requestAccounts" &&
-        request["method"] != "eth_blockNumber" &&
-        request["method"] != "eth_accounts" &&
-        request["method"] != "eth_syncing" &&
-        request["method"] != "eth_getBalance"
-       ) { // eth_call is garbage for us, do not print it
-      //std::cout << "Request: " << request.dump(2) << std::endl;
-      //std::cout << "Response: " << response.dump(2) << std::endl;
+      response["result"] = id;
     }
+    session_->do_write(response.dump());
+    return method;
+  } else if (request["method"] == "eth_unsubscribe") {
+    json params = (request.contains("params")) ? request["params"] : json::array();
+    std::string id = (params.is_array() && params.size() > 0 && params[0].is_string())
+      ? params[0].get<std::string>() : "";
+    response["result"] = SubscriptionHub::unsubscribe(id, session_.get());
+    session_->do_write(response.dump());
+    return method;
+  } else if (request["method"] != "eth_requestAccounts" &&
+    request["method"] != "eth_accounts" &&
+    request["method"] != "eth_sendTransaction"
+  ) {
+    json params = (request.contains("params")) ? request["params"] : json::array();
+    RPCBatcher::callAsync(request["method"].get<std::string>(), params, [=](json answer){
+      answer["id"] = request["id"];
+      session_->do_write(answer.dump());
+    }, true);
+    return method;
+  }
 
-    // This section below is confusing
-    // Due to the nature of being asynchronous
-    // We need to wait until the user have provided permission
-    // to connect with the website
-    if (requirePermission == true) {
-      this->permissionListMutex.lock();
-      bool found = false;
-      bool permission = false;
-      for (auto websitePermission : permissionList) {
-        if (request["__frameOrigin"].get<std::string>() == websitePermission.first) {
-          permission = websitePermission.second;
-          found = true;
-        }
-      }
-      if (!found) {
-        // Ask user to give permission or not.
-        //std::cout << "Lock global" << std::endl;
-        globalUserInputRequest.lock();
-        //std::cout << "Global locked" << std::endl;
-        PLuserInputRequest.lock();
-        // Tell QML to show and ask for permission for given website
-        std::string website = request["__frameOrigin"];
-        emit askForPermission(QString::fromStdString(website));
-        PLuserInputAnswer.lock();
-        PLuserInputAnswer.lock(); // Wait until user completed the input
-        // The reason to lock twice, is to give "control" of this thread to
-        // The function "addToPermissionList", which will unlock this thread after
-        // user input.
-        // Check what permission he gave for the website.
-        for (auto websitePermission : permissionList) {
-          if (request["__frameOrigin"].get<std::string>() == websitePermission.first)
-            permission = websitePermission.second;
-        }
-        PLuserInputAnswer.unlock();
-        PLuserInputRequest.unlock();
-        //std::cout << "Unlock global" << std::endl;
-        globalUserInputRequest.unlock();
-        //std::cout << "Global unlocked" << std::endl;
-      }
+  // The remaining requests might have to wait for user input. Those are
+  // parked and finished when the user answers, so the executor's workers
+  // are never held up by a dialog.
 
-      this->permissionListMutex.unlock();
-      if (permission == false) {
-        session_->close(); // Close the session if not permitted.
-        return; // We should not answer the website
-      }
+  // For security reasons, we lock out the possibility for the website
+  // To get the user address until he approves it
+  if (!request.contains("__frameOrigin") || !request["__frameOrigin"].is_string()) {
+    session_->close(); // Close the session if not permitted.
+    return method; // We should not answer the website
+  }
+  std::string website = request["__frameOrigin"].get<std::string>();
+  checkPermission(website, [this, request, response, website, session_](bool allowed){
+    if (!allowed) {
+      session_->close(); // Close the session if not permitted.
+      return; // We should not answer the website
+    }
+    json answer = response;
+    if (request["method"] == "eth_requestAccounts" || request["method"] == "eth_accounts") {
+      answer["result"] = json::array();
+      answer["result"].push_back(this->getCurrentAccount().toStdString());
+      session_->do_write(answer.dump());
+      return;
     }
 
     // Process with a transaction request.
-    if (requestTransaction) {
-      //std::cout << "Lock global TX" << std::endl;
-      globalUserInputRequest.lock();
-      //std::cout << "Global locked TX" << std::endl;
-      requestTransactionMutex.lock();
-      // 4001 	User Rejected Request 	The user rejected the request.
-      RTuserInputRequest.lock();
-      RTuserInputAnswer.lock();
-      std::string data, from, gas, to, website, value;
+    std::string data, from, gas, to, value;
+    try {
       // Optional! empty if there is none
       if (request["params"][0].contains("data")) {
         data = request["params"][0]["data"];
@@ -132,12 +121,31 @@ void QmlSystem::handleServer(std::string inputStr, std::shared_ptr<session> sess
         gas = "0xc3500";
       }
       to = request["params"][0]["to"];
-      website = request["__frameOrigin"];
       if (request["params"][0].contains("value")) { // Value input is optional! check if exists to set it properly.
         value = request["params"][0]["value"];
       } else {
         value = "0x0";
       }
+    } catch (std::exception &e) {
+      answer["error"]["code"] = -32602;
+      answer["error"]["message"] = "Invalid params";
+      session_->do_write(answer.dump());
+      return;
+    }
+    queueUserPrompt([this, answer, data, from, gas, to, value, website, session_](){
+      this->userPromptMutex.lock();
+      this->txPromptAnswer = [answer, session_](std::string txid){
+        json txAnswer = answer;
+        if (txid == "") { // Treat "refused" response
+          // 4001 	User Rejected Request 	The user rejected the request.
+          txAnswer["error"]["code"] = 4001;
+          txAnswer["error"]["message"] = "The user rejected the request";
+        } else {
+          txAnswer["result"] = txid;
+        }
+        session_->do_write(txAnswer.dump());
+      };
+      this->userPromptMutex.unlock();
       emit askForTransaction(
         QString::fromStdString(data),
         QString::fromStdString(from),
@@ -146,25 +154,9 @@ void QmlSystem::handleServer(std::string inputStr, std::shared_ptr<session> sess
         QString::fromStdString(value),
         QString::fromStdString(website)
       );
-      RTuserInputAnswer.lock(); // We lock twice for the same reason as above
-      if (RTtxid == "") { // Treat "refused" response
-        // 4001 	User Rejected Request 	The user rejected the request.
-        response["error"]["code"] = 4001;
-        response["error"]["message"] = "The user rejected the request";
-      } else {
-        response["result"] = RTtxid;
-      }
-      RTuserInputAnswer.unlock();
-      RTuserInputRequest.unlock();
-      requestTransactionMutex.unlock();
-      //std::cout << "Unlock global TX" << std::endl;
-      globalUserInputRequest.unlock();
-      //std::cout << "Global unlocked TX" << std::endl;
-    }
-    //std::cout << "Writing back: " << response.dump() << std::endl;
-    session_->do_write(response.dump());
+    });
   });
-  return;
+  return method;
 }
 
 void QmlSystem::setWSServer() {
@@ -183,26 +175,108 @@ Q_INVOKABLE void QmlSystem::stopWSServer() {
   this->s.stop();
 }
 
+QString QmlSystem::getWSServerStats() {
+  BridgeStats stats = this->s.getStats();
+  json ret;
+  ret["queued"] = stats.queued;
+  ret["maxDepth"] = stats.maxDepth;
+  ret["pauses"] = stats.pauses;
+  ret["methods"] = json::object();
+  for (std::pair<const std::string, BridgeMethodStats> &m : stats.methods) {
+    json method;
+    method["calls"] = m.second.calls;
+    method["avgWaitMs"] = m.second.totalWaitMs / m.second.calls;
+    method["avgRunMs"] = m.second.totalRunMs / m.second.calls;
+    method["maxWaitMs"] = m.second.maxWaitMs;
+    method["maxRunMs"] = m.second.maxRunMs;
+    ret["methods"][m.first] = method;
+  }
+  return QString::fromStdString(ret.dump());
+}
+
+bool QmlSystem::findPermission(std::string website, bool &allowed) {
+  std::shared_ptr<const std::unordered_map<std::string, bool>> snapshot = std::atomic_load(&this->permissions);
+  auto it = snapshot->find(website);
+  if (it == snapshot->end()) { return false; }
+  allowed = it->second;
+  return true;
+}
+
+void QmlSystem::checkPermission(std::string website, std::function<void(bool)> done) {
+  bool allowed = false;
+  if (findPermission(website, allowed)) { done(allowed); return; }
+
+  // The first request from an origin asks the user, the others wait for the same answer
+  this->permissionPromptsMutex.lock();
+  auto it = this->permissionPrompts.find(website);
+  bool first = (it == this->permissionPrompts.end());
+  this->permissionPrompts[website].push_back(done);
+  this->permissionPromptsMutex.unlock();
+  if (!first) { return; }
+
+  queueUserPrompt([this, website](){
+    bool known = false;
+    this->userPromptMutex.lock();
+    this->permissionPromptOrigin = website;
+    this->userPromptMutex.unlock();
+    if (findPermission(website, known)) {
+      // Answered while waiting for the dialog (e.g. the list was reloaded)
+      addToPermissionList(QString::fromStdString(website), known);
+    } else {
+      emit askForPermission(QString::fromStdString(website));
+    }
+  });
+}
+
+void QmlSystem::queueUserPrompt(std::function<void()> show) {
+  this->userPromptMutex.lock();
+  if (this->userPromptOpen) {
+    this->userPrompts.push_back(show);
+    this->userPromptMutex.unlock();
+    return;
+  }
+  this->userPromptOpen = true;
+  this->userPromptMutex.unlock();
+  show();
+}
+
+void QmlSystem::nextUserPrompt() {
+  std::function<void()> show;
+  this->userPromptMutex.lock();
+  this->permissionPromptOrigin = "";
+  this->txPromptAnswer = nullptr;
+  if (this->userPrompts.empty()) {
+    this->userPromptOpen = false;
+  } else {
+    show = this->userPrompts.front();
+    this->userPrompts.pop_front();
+  }
+  this->userPromptMutex.unlock();
+  if (show) { show(); }
+}
+
 Q_INVOKABLE void QmlSystem::loadPermissionList() {
-  // No lock required as there will be only one thread reading/writing to the permission list
   std::string configValue  = getConfigValue(QString::fromStdString("websitePermissions")).toStdString();
+  std::shared_ptr<std::unordered_map<std::string, bool>> newPermissions =
+    std::make_shared<std::unordered_map<std::string, bool>>();
   if (!(configValue.find("NotFound") != std::string::npos)) {
     json storedPermissionList = json::parse(configValue);
-    // Clear the permission list.
-    permissionList.clear();
     if (!storedPermissionList.empty()) {
       for (auto item : storedPermissionList.items()) {
-        permissionList.push_back(std::make_pair(item.key(), item.value()));
+        (*newPermissions)[item.key()] = item.value().get<bool>();
       }
     }
   }
+  // Readers still holding the old snapshot keep using it until they're done
+  std::atomic_store(
+    &this->permissions,
+    std::shared_ptr<const std::unordered_map<std::string, bool>>(newPermissions)
+  );
 }
 
 Q_INVOKABLE void QmlSystem::addToPermissionList(QString website, bool allow) {
-  // We don't need a mutex lock here,
-  // Because handleServer is waiting for it to be unlocked below
-  // In order to read the permissionList
-  // Meaning, there is only one thread accessing the variabl
+  // Writers are serialized, readers are never blocked
+  this->permissionWriteMutex.lock();
   std::string configValue = getConfigValue(QString::fromStdString("websitePermissions")).toStdString();
   json storedPermissionList;
   if (!(configValue.find("NotFound") != std::string::npos)) {
@@ -211,22 +285,41 @@ Q_INVOKABLE void QmlSystem::addToPermissionList(QString website, bool allow) {
   storedPermissionList[website.toStdString()] = allow;
   setConfigValue(QString::fromStdString("websitePermissions"), QString::fromStdString(storedPermissionList.dump()));
   loadPermissionList();
-  PLuserInputAnswer.unlock(); // Unlock for handleServer self-lock.
+  this->permissionWriteMutex.unlock();
+
+  // Answer everyone waiting on this origin
+  std::vector<std::function<void(bool)>> waiting;
+  this->permissionPromptsMutex.lock();
+  auto it = this->permissionPrompts.find(website.toStdString());
+  if (it != this->permissionPrompts.end()) {
+    waiting.swap(it->second);
+    this->permissionPrompts.erase(it);
+  }
+  this->permissionPromptsMutex.unlock();
+  for (std::function<void(bool)> &done : waiting) { done(allow); }
+
+  // Move on to the next dialog if this one was for a WS Server request
+  this->userPromptMutex.lock();
+  bool wasOpen = (this->userPromptOpen && this->permissionPromptOrigin == website.toStdString());
+  this->userPromptMutex.unlock();
+  if (wasOpen) { nextUserPrompt(); }
 }
 
 Q_INVOKABLE void QmlSystem::requestedTransactionStatus(bool approved, QString txid) {
-  if (approved) {
-    RTtxid = txid.toStdString();
-    RTuserInputAnswer.unlock();
-  } else {
-    RTtxid = "";
-    RTuserInputAnswer.unlock();
-  }
+  // Only answers the transaction dialog of a WS Server request, if one is open
+  this->userPromptMutex.lock();
+  std::function<void(std::string)> answer = this->txPromptAnswer;
+  this->txPromptAnswer = nullptr;
+  this->userPromptMutex.unlock();
+  if (!answer) { return; }
+  answer((approved) ? txid.toStdString() : "");
+  nextUserPrompt();
 }
 
 QString QmlSystem::getWebsitePermissionList() {
   json ret;
-  for (auto permission : permissionList) {
+  std::shared_ptr<const std::unordered_map<std::string, bool>> snapshot = std::atomic_load(&this->permissions);
+  for (auto permission : *snapshot) {
     ret[permission.first] = permission.second;
   }
   return QString::fromStdString(ret.dump());
@@ -234,6 +327,8 @@ QString QmlSystem::getWebsitePermissionList() {
 
 void QmlSystem::clearWebsitePermissionList() {
   json cleanJson;
+  this->permissionWriteMutex.lock();
   setConfigValue(QString::fromStdString("websitePermissions"), QString::fromStdString(cleanJson.dump()));
   loadPermissionList();
+  this->permissionWriteMutex.unlock();
 }
@@ -125,6 +125,14 @@ void QmlSystem::storePass(QString pass) {
   int minutes = std::stoi(this->w.getConfigValue("storePass"));
   std::time_t deadline = std::time(nullptr) + (minutes * 60); // std::time is in seconds
   this->w.startPassThread(pass.toStdString(), deadline);
+  // Also keep the current Account's secret unlocked for the same time,
+  // so signing doesn't have to decrypt the key file again
+  std::string address = this->w.getCurrentAccount().first;
+  if (!address.empty() && minutes > 0) {
+    QtConcurrent::run([=](){
+      this->w.unlockAccount(address, pass.toStdString(), minutes * 60, 0);
+    });
+  }
 }
 
 QString QmlSystem::retrievePass() {
@@ -133,6 +141,7 @@ QString QmlSystem::retrievePass() {
 
 void QmlSystem::resetPass() {
   this->w.stopPassThread();
+  this->w.lockAccounts();
 }
 
 void QmlSystem::checkIfUrlExists(QUrl url) {
@@ -18,6 +18,13 @@
 #include <QtQml/QQmlApplicationEngine>
 #include <QtWidgets/QApplication>
 
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
 #include <lib/ledger/ledger.h>
 
 #include <network/API.h>
@@ -26,9 +33,15 @@
 #include <core/Utils.h>
 #include <core/Wallet.h>
 #include <network/Graph.h>
+#include <network/Multicall.h>
 #include <network/Pangolin.h>
 #include <network/Staking.h>
 #include <network/ParaSwap.h>
+#include <network/PortfolioService.h>
+#include <network/PriceStore.h>
+#include <network/RPCBatcher.h>
+#include <network/SubscriptionHub.h>
+#include <network/SwapRouter.h>
 
 #include "version.h"
 
@@ -50,20 +63,55 @@ class QmlSystem : public QObject {
     QString currentHardwareAccountPath;
     QQmlApplicationEngine *engine = nullptr;
 
-    // Permission list of websites allowed to join.
-    std::vector<std::pair<std::string,bool>> permissionList;
+    /**
+     * Permissions of websites allowed (or not) to join, by origin.
+     * Readers take the current snapshot with std::atomic_load and never lock.
+     * Writers build a new map and swap it in with std::atomic_store,
+     * one at a time (permissionWriteMutex).
+     */
+    std::shared_ptr<const std::unordered_map<std::string, bool>> permissions =
+      std::make_shared<const std::unordered_map<std::string, bool>>();
+    std::mutex permissionWriteMutex;
+
+    /**
+     * Requests waiting for the user's permission answer, by origin.
+     * Requests from an origin with a pending prompt are parked here and
+     * finished when the user answers, so they don't hold up any worker.
+     */
+    std::map<std::string, std::vector<std::function<void(bool)>>> permissionPrompts;
+    std::mutex permissionPromptsMutex;
+
+    // Get the permission for a website from the current snapshot.
+    // Returns false if the website isn't in it, otherwise sets allowed.
+    bool findPermission(std::string website, bool &allowed);
+
+    /**
+     * Get the permission for a website, asking the user if it isn't known yet.
+     * done is called right away if the permission is known, otherwise
+     * from addToPermissionList() once the user answers.
+     */
+    void checkPermission(std::string website, std::function<void(bool)> done);
+
+    // Fetch and cache the metadata of any tokens not in the wallet's cache yet, in one read.
+    void fetchARC20TokenMeta(std::vector<std::string> addresses);
+
+    /**
+     * Dialogs for WS Server requests (permission/transaction) waiting to be
+     * shown, one at a time. The open one is either a permission dialog
+     * (permissionPromptOrigin) or a transaction dialog (txPromptAnswer),
+     * and the next one is shown once it's answered.
+     */
+    std::deque<std::function<void()>> userPrompts;
+    bool userPromptOpen = false;
+    std::string permissionPromptOrigin;
+    std::function<void(std::string)> txPromptAnswer;
+    std::mutex userPromptMutex;
 
-    // Mutex locks for when dealing with WS Server.
-    std::mutex permissionListMutex;
-    std::mutex globalUserInputRequest;
-    std::mutex PLuserInputRequest;
-    std::mutex PLuserInputAnswer;
-    std::mutex requestTransactionMutex;
-    std::mutex RTuserInputRequest;
-    std::mutex RTuserInputAnswer;
+    // Show a dialog now if none is open, otherwise after the ones before it.
+    void queueUserPrompt(std::function<void()> show);
 
-    // String that will hold the TXID of an approved transaction.
-    std::string RTtxid = "";
+    // Close the current dialog and show the next one, if any.
+    void nextUserPrompt();
 
   public slots:
     // Clean database, threads, etc before changing the Account and Wallet, respectively
@@ -102,9 +150,13 @@ class QmlSystem : public QObject {
     void accountAllBalancesUpdated(
       QString address, QString tokenJsonListStr, QString CoinData, QString gasPrice
     );
+    void accountBalancesChanged(
+      QString address, QString tokenJsonListStr, QString CoinData, QString gasPrice, bool full
+    );
 
     // History screen signals
-    void historyLoaded(QString data);
+    void historyLoaded(QString data, QString nextCursor, bool hasMore, bool isNextPage);
+    void pendingTxStatusesRefreshed(int updated);
 
     // Send screen signals
     void operationOverride(
@@ -118,6 +170,7 @@ class QmlSystem : public QObject {
     void ledgerRequired(QString randomID);
     void ledgerDone(QString randomID);
     void accountNonceUpdate(QString nonce);
+    void txBatchSent(QString results, QString randomID);
 
     // Applications screen signals
     void appListDownloaded();
@@ -309,6 +362,12 @@ class QmlSystem : public QObject {
     // Get the balances of all registered tokens for a specific Account
     Q_INVOKABLE void getAccountAllBalances(QString address);
 
+    // Start/stop pushing the balances of an Account as they change (see PortfolioService).
+    // Emits accountBalancesChanged() with only what changed (CoinData and gasPrice
+    // are empty if unchanged), and accountNonceUpdate() when the nonce changes.
+    Q_INVOKABLE void startPortfolio(QString address);
+    Q_INVOKABLE void stopPortfolio();
+
     // (Re)Load the respective wallet databases.
     Q_INVOKABLE bool loadTokenDB();
     Q_INVOKABLE bool loadHistoryDB(QString address);
@@ -348,6 +407,9 @@ class QmlSystem : public QObject {
     );
     Q_INVOKABLE bool removeARC20Token(QString address);
 
+    // Add several tokens at once. Each item is a map with the same fields as above.
+    Q_INVOKABLE bool addARC20Tokens(QVariantList tokens);
+
     // Check if a token exists in the network.
     Q_INVOKABLE bool ARC20TokenExists(QString address);
 
@@ -361,13 +423,19 @@ class QmlSystem : public QObject {
     // HISTORY SCREEN FUNCTIONS
     // ======================================================================
 
-    // List the Account's transactions, updating their statuses on the spot if required.
+    // List a page of the Account's transactions, newest first, optionally
+    // only the ones with the given operation. Pass an empty cursor for the
+    // first page, and the cursor from the previous page for the next ones.
     // Emits historyLoaded()
-    Q_INVOKABLE void listAccountTransactions(QString address);
+    Q_INVOKABLE void listAccountTransactions(QString cursor, int limit, QString operation = "");
 
     // Update a given transaction's status.
     Q_INVOKABLE void updateTxStatus(QString txHash);
 
+    // Update the status of all pending transactions at once.
+    // Emits pendingTxStatusesRefreshed() with how many changed.
+    Q_INVOKABLE void refreshPendingTxStatuses();
+
     // Erase the whole transaction history.
     Q_INVOKABLE void eraseAllHistory();
 
@@ -423,6 +491,16 @@ class QmlSystem : public QObject {
       QString gasPrice, QString pass, QString txNonce, QString randomID
     );
 
+    // Sign and send several transactions from one Account at once.
+    // Each item in txs is an object with "to", "value", "txData" and "gas"
+    // (same formats as makeTransaction). Nonces are handled automatically.
+    // Not supported on Ledger Accounts, every result is an error then.
+    // Emits txBatchSent() with a JSON array of results, in order.
+    Q_INVOKABLE void makeTransactionBatch(
+      QString operation, QString from, QVariantList txs,
+      QString gasPrice, QString pass, QString randomID
+    );
+
     // Check if the transaction was confirmed or not, and if it's "stuck"
     Q_INVOKABLE void checkTransactionFor15s(QString txid, QString randomID);
 
@@ -474,12 +552,30 @@ class QmlSystem : public QObject {
       QString userAddress, QString fee, QString id
     );
 
+    /**
+     * Start/stop keeping Pangolin's reserves for local swap quotes (see SwapRouter),
+     * routing between the registered tokens and the base ones.
+     */
+    Q_INVOKABLE void startSwapRouter();
+    Q_INVOKABLE void stopSwapRouter();
+
+    /**
+     * Quote a swap locally over Pangolin's pairs, up to SwapRouter::maxHops.
+     * side is "SELL" (weiAmount is the input) or "BUY" (weiAmount is the output),
+     * same as ParaSwap. Returns the other amount (in Wei) as "amount" and the
+     * token addresses of the route as "path", or an empty map if there's no route.
+     */
+    Q_INVOKABLE QVariantMap quoteSwap(
+      QString srcToken, QString destToken, QString weiAmount, QString side
+    );
+
     // ======================================================================
     // WEBSOCKET SERVER FUNCTIONS
     // ======================================================================
 
-    // Process the received messages from the WS server
-    void handleServer(std::string inputStr, std::shared_ptr<session> session_);
+    // Process the received messages from the WS server.
+    // Runs in the server's executor, returns the method for its metrics.
+    std::string handleServer(std::string inputStr, std::shared_ptr<session> session_);
 
     // Set WS server to a pointer of this
     void setWSServer();
@@ -490,6 +586,9 @@ class QmlSystem : public QObject {
     // Stop WS Server when closing an account
     Q_INVOKABLE void stopWSServer();
 
+    // Get the WS Server's queue and per-method latency metrics as JSON.
+    Q_INVOKABLE QString getWSServerStats();
+
     // Ask for user input to approve/refuse a transaction
     Q_INVOKABLE void addToPermissionList(QString website, bool allow);
 
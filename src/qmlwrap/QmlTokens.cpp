@@ -60,7 +60,9 @@ QVariantList QmlSystem::getARC20TokenList() {
   );
   json tokenlist = json::parse(Utils::readJSONFile(filePath));
   json tokens = tokenlist["tokens"];
+  std::vector<std::string> addresses;
   for (auto& token : tokens) {
+    addresses.push_back(token["contract-address"].get<std::string>());
     QVariantMap tokenObj;
     tokenObj["address"] = QString::fromStdString(token["contract-address"].get<std::string>());
     tokenObj["name"] = QString::fromStdString(token["name"].get<std::string>());
@@ -69,127 +71,123 @@ QVariantList QmlSystem::getARC20TokenList() {
     tokenObj["icon"] = QString::fromStdString(token["logoURI"].get<std::string>());
     ret << tokenObj;
   }
+  // Cache the whole list's metadata in the background, so picking any of them is free
+  QtConcurrent::run([=](){ fetchARC20TokenMeta(addresses); });
   return ret;
 }
 
 bool QmlSystem::addARC20Token(
   QString address, QString symbol, QString name, int decimals, QString avaxPairContract
 ) {
-  return QmlSystem::w.addARC20Token(
+  bool ret = QmlSystem::w.addARC20Token(
     address.toStdString(), symbol.toStdString(), name.toStdString(),
     decimals, avaxPairContract.toStdString()
   );
+  if (ret) { PortfolioService::setTokens(QmlSystem::w.getARC20Tokens()); }
+  return ret;
+}
+
+bool QmlSystem::addARC20Tokens(QVariantList tokens) {
+  std::vector<ARC20Token> tokenList;
+  for (QVariant item : tokens) {
+    QVariantMap tokenObj = item.toMap();
+    ARC20Token token;
+    token.address = tokenObj["address"].toString().toStdString();
+    token.symbol = tokenObj["symbol"].toString().toStdString();
+    token.name = tokenObj["name"].toString().toStdString();
+    token.decimals = tokenObj["decimals"].toInt();
+    token.avaxPairContract = tokenObj["avaxPairContract"].toString().toStdString();
+    tokenList.push_back(token);
+  }
+  bool ret = QmlSystem::w.addARC20Tokens(tokenList);
+  if (ret) { PortfolioService::setTokens(QmlSystem::w.getARC20Tokens()); }
+  return ret;
 }
 
 bool QmlSystem::removeARC20Token(QString address) {
-  return QmlSystem::w.removeARC20Token(address.toStdString());
+  bool ret = QmlSystem::w.removeARC20Token(address.toStdString());
+  if (ret) { PortfolioService::setTokens(QmlSystem::w.getARC20Tokens()); }
+  return ret;
+}
+
+void QmlSystem::fetchARC20TokenMeta(std::vector<std::string> addresses) {
+  // Only ask for what isn't cached yet
+  std::vector<std::string> missing;
+  for (std::string &address : addresses) {
+    ARC20Token cached;
+    bool isToken;
+    std::string addressStr = Utils::toCamelCaseAddress(address);
+    if (!QmlSystem::w.getARC20TokenMeta(addressStr, cached, isToken)) { missing.push_back(addressStr); }
+  }
+  if (missing.empty()) { return; }
+
+  // Six reads per address, all of them in a single eth_call through Multicall
+  std::vector<MulticallCall> calls;
+  for (std::string &address : missing) {
+    calls.push_back(Multicall::makeCall(address, Pangolin::ERC20Funcs["totalSupply"]));
+    calls.push_back(Multicall::makeCall(address, Pangolin::ERC20Funcs["balanceOf"] + Utils::addressToHex(address)));
+    calls.push_back(Multicall::makeCall(address, Pangolin::ERC20Funcs["name"]));
+    calls.push_back(Multicall::makeCall(address, Pangolin::ERC20Funcs["symbol"]));
+    calls.push_back(Multicall::makeCall(address, Pangolin::ERC20Funcs["decimals"]));
+    calls.push_back(Multicall::makeCall(Pangolin::contracts["factory"], Pangolin::factoryFuncs["getPair"]
+      + Utils::addressToHex(address) + Utils::addressToHex(Pangolin::contracts["AVAX"])));
+  }
+  std::vector<MulticallResult> results = Multicall::call(calls);
+
+  std::vector<ARC20Token> tokens;
+  std::vector<std::string> nonTokens;
+  for (size_t i = 0; i < missing.size(); i++) {
+    MulticallResult* r = &results[i * 6];
+    // Don't cache anything if any read went unanswered (e.g. connection error)
+    // or the factory call failed, as that says nothing about the address.
+    // An address's calls can be split between two chunks, so all are checked
+    bool answered = r[5].success;
+    for (size_t j = 0; j < 6; j++) { if (!r[j].answered) { answered = false; } }
+    if (!answered) { continue; }
+    bool isToken = true;
+    for (size_t j = 0; j < 5; j++) {
+      if (!r[j].success || r[j].returnData == "0x" || r[j].returnData == "") { isToken = false; }
+    }
+    ARC20Token token;
+    if (isToken) {
+      try {
+        token.address = missing[i];
+        token.name = Utils::bytesFromHex(r[2].returnData);
+        token.symbol = Utils::bytesFromHex(r[3].returnData);
+        token.decimals = boost::lexical_cast<int>(Utils::uintFromHex(r[4].returnData));
+        token.avaxPairContract = Utils::addressFromHex(r[5].returnData);
+      } catch (std::exception &e) {
+        // e.g. name/symbol as bytes32 instead of string
+        Utils::logToDebug(std::string("Token metadata ERROR: ") + e.what());
+        isToken = false;
+      }
+    }
+    if (isToken) { tokens.push_back(token); } else { nonTokens.push_back(missing[i]); }
+  }
+  QmlSystem::w.saveARC20TokenMeta(tokens, nonTokens);
 }
 
 bool QmlSystem::ARC20TokenExists(QString address) {
+  ARC20Token token;
+  bool isToken = false;
   std::string addressStr = Utils::toCamelCaseAddress(address.toStdString());
-  json supplyJson, balanceJson, nameJson, symbolJson, decimalsJson;
-  json supplyJsonArr = json::array();
-  json balanceJsonArr = json::array();
-  json nameJsonArr = json::array();
-  json symbolJsonArr = json::array();
-  json decimalsJsonArr = json::array();
-  supplyJson["to"] = balanceJson["to"] = addressStr;
-  nameJson["to"] = symbolJson["to"] = decimalsJson["to"] = addressStr;
-  supplyJson["data"] = Pangolin::ERC20Funcs["totalSupply"];
-  balanceJson["data"] = Pangolin::ERC20Funcs["balanceOf"] + Utils::addressToHex(addressStr);
-  nameJson["data"] = Pangolin::ERC20Funcs["name"];
-  symbolJson["data"] = Pangolin::ERC20Funcs["symbol"];
-  decimalsJson["data"] = Pangolin::ERC20Funcs["decimals"];
-  supplyJsonArr.push_back(supplyJson);
-  supplyJsonArr.push_back("latest");
-  balanceJsonArr.push_back(balanceJson);
-  balanceJsonArr.push_back("latest");
-  nameJsonArr.push_back(nameJson);
-  nameJsonArr.push_back("latest");
-  symbolJsonArr.push_back(symbolJson);
-  symbolJsonArr.push_back("latest");
-  decimalsJsonArr.push_back(decimalsJson);
-  decimalsJsonArr.push_back("latest");
-  Request supplyReq{1, "2.0", "eth_call", supplyJsonArr};
-  Request balanceReq{1, "2.0", "eth_call", balanceJsonArr};
-  Request nameReq{1, "2.0", "eth_call", nameJsonArr};
-  Request symbolReq{1, "2.0", "eth_call", symbolJsonArr};
-  Request decimalsReq{1, "2.0", "eth_call", decimalsJsonArr};
-  std::string supplyQuery, supplyResp, supplyHex;
-  std::string balanceQuery, balanceResp, balanceHex;
-  std::string nameQuery, nameResp, nameHex;
-  std::string symbolQuery, symbolResp, symbolHex;
-  std::string decimalsQuery, decimalsResp, decimalsHex;
-  supplyQuery = API::buildRequest(supplyReq);
-  balanceQuery = API::buildRequest(balanceReq);
-  nameQuery = API::buildRequest(nameReq);
-  symbolQuery = API::buildRequest(symbolReq);
-  decimalsQuery = API::buildRequest(decimalsReq);
-  supplyResp = API::httpGetRequest(supplyQuery);
-  balanceResp = API::httpGetRequest(balanceQuery);
-  nameResp = API::httpGetRequest(nameQuery);
-  symbolResp = API::httpGetRequest(symbolQuery);
-  decimalsResp = API::httpGetRequest(decimalsQuery);
-  json supplyRespJson = json::parse(supplyResp);
-  json balanceRespJson = json::parse(balanceResp);
-  json nameRespJson = json::parse(nameResp);
-  json symbolRespJson = json::parse(symbolResp);
-  json decimalsRespJson = json::parse(decimalsResp);
-  try {
-    supplyHex = supplyRespJson["result"].get<std::string>();
-    balanceHex = balanceRespJson["result"].get<std::string>();
-    nameHex = nameRespJson["result"].get<std::string>();
-    symbolHex = symbolRespJson["result"].get<std::string>();
-    decimalsHex = decimalsRespJson["result"].get<std::string>();
-  } catch (...) { return false; }
-  if (supplyHex == "0x" || supplyHex == "") { return false; }
-  if (balanceHex == "0x" || balanceHex == "") { return false; }
-  if (nameHex == "0x" || nameHex == "") { return false; }
-  if (symbolHex == "0x" || symbolHex == "") { return false; }
-  if (decimalsHex == "0x" || decimalsHex == "") { return false; }
-  return true;
+  if (!QmlSystem::w.getARC20TokenMeta(addressStr, token, isToken)) {
+    fetchARC20TokenMeta({addressStr});
+    if (!QmlSystem::w.getARC20TokenMeta(addressStr, token, isToken)) { return false; }
+  }
+  return isToken;
 }
 
 QVariantMap QmlSystem::getARC20TokenData(QString address) {
-  std::string addressStr = Utils::toCamelCaseAddress(address.toStdString());
-  json nameJson, symbolJson, decimalsJson, pairJson;
-  nameJson["to"] = symbolJson["to"] = decimalsJson["to"] = addressStr;
-  pairJson["to"] = Pangolin::contracts["factory"];
-  nameJson["data"] = Pangolin::ERC20Funcs["name"];
-  symbolJson["data"] = Pangolin::ERC20Funcs["symbol"];
-  decimalsJson["data"] = Pangolin::ERC20Funcs["decimals"];
-  pairJson["data"] = Pangolin::factoryFuncs["getPair"]
-    + Utils::addressToHex(addressStr)
-    + Utils::addressToHex(Pangolin::contracts["AVAX"]);
-  Request nameReq{1, "2.0", "eth_call", {nameJson, "latest"}};
-  Request symbolReq{1, "2.0", "eth_call", {symbolJson, "latest"}};
-  Request decimalsReq{1, "2.0", "eth_call", {decimalsJson, "latest"}};
-  Request pairReq{1, "2.0", "eth_call", {pairJson, "latest"}};
-  std::string nameQuery, nameResp, nameHex, symbolQuery, symbolResp, symbolHex,
-    decimalsQuery, decimalsResp, decimalsHex, pairQuery, pairResp, pairHex;
-  nameQuery = API::buildRequest(nameReq);
-  symbolQuery = API::buildRequest(symbolReq);
-  decimalsQuery = API::buildRequest(decimalsReq);
-  pairQuery = API::buildRequest(pairReq);
-  nameResp = API::httpGetRequest(nameQuery);
-  symbolResp = API::httpGetRequest(symbolQuery);
-  decimalsResp = API::httpGetRequest(decimalsQuery);
-  pairResp = API::httpGetRequest(pairQuery);
-  json nameRespJson = json::parse(nameResp);
-  json symbolRespJson = json::parse(symbolResp);
-  json decimalsRespJson = json::parse(decimalsResp);
-  json pairRespJson = json::parse(pairResp);
-  nameHex = nameRespJson["result"].get<std::string>();
-  symbolHex = symbolRespJson["result"].get<std::string>();
-  decimalsHex = decimalsRespJson["result"].get<std::string>();
-  pairHex = pairRespJson["result"].get<std::string>();
   ARC20Token token;
-  token.address = addressStr;
-  token.name = Utils::bytesFromHex(nameHex);
-  token.symbol = Utils::bytesFromHex(symbolHex);
-  token.decimals = boost::lexical_cast<int>(Utils::uintFromHex(decimalsHex));
-  token.avaxPairContract = Utils::addressFromHex(pairHex);
+  bool isToken = false;
   QVariantMap tokenObj;
+  std::string addressStr = Utils::toCamelCaseAddress(address.toStdString());
+  if (!QmlSystem::w.getARC20TokenMeta(addressStr, token, isToken)) {
+    fetchARC20TokenMeta({addressStr});
+    if (!QmlSystem::w.getARC20TokenMeta(addressStr, token, isToken)) { return tokenObj; }
+  }
+  if (!isToken) { return tokenObj; }
   tokenObj.insert("address", QString::fromStdString(token.address));
   tokenObj.insert("symbol", QString::fromStdString(token.symbol));
   tokenObj.insert("name", QString::fromStdString(token.name));
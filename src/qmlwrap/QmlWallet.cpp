@@ -36,6 +36,9 @@ void QmlSystem::loadWallet(QString folder, QString pass) {
 }
 
 void QmlSystem::closeWallet() {
+  PortfolioService::stop();
+  SwapRouter::stop();
+  PriceStore::setTable(DBTable());
   this->w.close();
 }
 